@@ -0,0 +1,48 @@
+/* Run time counter of the FreeRTOS run time stats, see configGENERATE_RUN_TIME_STATS in FreeRTOSConfig.h.
+ *
+ * The counter is the 32768Hz RTC0 counter, started by the BLE stack at boot and also used by the event trace:
+ * it runs from the low frequency clock, which stays on while the CPU sleeps, so it costs no current and no interrupt.
+ * The time spent sleeping in the idle task is charged to it. Interrupt handlers are charged to the task they
+ * interrupted. With a resolution of about 30us, the run time of the tasks is sampled rather than measured:
+ * a task that runs for less than a tick is charged a whole tick or nothing, which evens out over the minute of a
+ * period.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if configGENERATE_RUN_TIME_STATS == 1
+
+  /* The RTC counter is 24 bits wide */
+  #define RUN_TIME_STATS_COUNTER_MASK 0x00FFFFFFUL
+
+static uint32_t lastTicks;
+static uint64_t totalTicks;
+static uint32_t switchCounts[RUN_TIME_STATS_MAX_TASKS];
+
+void RunTimeStatsInit(void) {
+  lastTicks = NRF_RTC0->COUNTER;
+  totalTicks = 0;
+}
+
+/* Called by the kernel on each context switch, with the scheduler suspended or from the PendSV handler:
+ * the counter wraps after 512s, much more than the time between 2 switches (the system task wakes up every 2s). */
+uint32_t RunTimeStatsCounter(void) {
+  uint32_t ticks = NRF_RTC0->COUNTER;
+  totalTicks += (ticks - lastTicks) & RUN_TIME_STATS_COUNTER_MASK;
+  lastTicks = ticks;
+  /* In microseconds */
+  return (uint32_t) (totalTicks * 15625 / 512);
+}
+
+void RunTimeStatsTaskSwitchedIn(uint32_t taskNumber) {
+  if (taskNumber < RUN_TIME_STATS_MAX_TASKS) {
+    switchCounts[taskNumber]++;
+  }
+}
+
+uint32_t RunTimeStatsSwitchCount(uint32_t taskNumber) {
+  return taskNumber < RUN_TIME_STATS_MAX_TASKS ? switchCounts[taskNumber] : 0;
+}
+
+#endif
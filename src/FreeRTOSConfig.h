@@ -74,7 +74,7 @@
 #define configUSE_TIME_SLICING                  0
 #define configUSE_NEWLIB_REENTRANT              0
 #define configENABLE_BACKWARD_COMPATIBILITY     0
-#define configUSE_TASK_NOTIFICATIONS            0
+#define configUSE_TASK_NOTIFICATIONS            1
 
 /* Hook function related definitions. */
 #define configUSE_IDLE_HOOK            0
@@ -83,10 +83,21 @@
 #define configUSE_MALLOC_FAILED_HOOK   1
 
 /* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS        0
+#define configGENERATE_RUN_TIME_STATS        1
 #define configUSE_TRACE_FACILITY             1
 #define configUSE_STATS_FORMATTING_FUNCTIONS 0
 
+/* The run time counter counts the time in microseconds, from the RTC0 counter, see FreeRTOS/port_runtime_stats.c.
+ * The number of times each task is scheduled in is counted too, for the tasks numbered below RUN_TIME_STATS_MAX_TASKS. */
+#define RUN_TIME_STATS_MAX_TASKS                 16
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() RunTimeStatsInit()
+#define portGET_RUN_TIME_COUNTER_VALUE()         RunTimeStatsCounter()
+#define traceTASK_SWITCHED_IN()                              \
+  {                                                          \
+    RunTimeStatsTaskSwitchedIn(pxCurrentTCB->uxTCBNumber);   \
+    TraceTaskSwitchedIn(pxCurrentTCB->uxTCBNumber);          \
+  }
+
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES           0
 #define configMAX_CO_ROUTINE_PRIORITIES (2)
@@ -185,6 +196,20 @@ standard names - or at least those used in the unmodified vector table. */
     #include <stdint.h>
 extern uint32_t SystemCoreClock;
   #endif
+
+  #include <stdint.h>
+  #ifdef __cplusplus
+extern "C" {
+  #endif
+void RunTimeStatsInit(void);
+uint32_t RunTimeStatsCounter(void);
+void RunTimeStatsTaskSwitchedIn(uint32_t taskNumber);
+uint32_t RunTimeStatsSwitchCount(uint32_t taskNumber);
+/* See utility/Trace.h */
+void TraceTaskSwitchedIn(uint32_t taskNumber);
+  #ifdef __cplusplus
+}
+  #endif
 #endif /* !assembler */
 
 /** Implementation note:  Use this with caution and set this to 1 ONLY for debugging
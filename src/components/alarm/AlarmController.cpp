@@ -25,7 +25,7 @@ using namespace Pinetime::Controllers;
 using namespace std::chrono_literals;
 
 AlarmController::AlarmController(Controllers::DateTime& dateTimeController, Controllers::FS& fs)
-  : dateTimeController {dateTimeController}, fs {fs} {
+  : dateTimeController {dateTimeController}, fs {fs}, store {fs} {
 }
 
 namespace {
@@ -142,16 +142,23 @@ void AlarmController::SetRecurrence(RecurType recurrence) {
 }
 
 void AlarmController::LoadSettingsFromFile() {
-  lfs_file_t alarmFile;
   AlarmSettings alarmBuffer;
 
-  if (fs.FileOpen(&alarmFile, "/.system/alarm.dat", LFS_O_RDONLY) != LFS_ERR_OK) {
-    NRF_LOG_WARNING("[AlarmController] Failed to open alarm data file");
-    return;
+  if (store.Get(KeyValueStore::Key::Alarm, &alarmBuffer, sizeof(alarmBuffer)) != sizeof(alarmBuffer)) {
+    // Alarm saved to a file by previous versions, moved to the store
+    lfs_file_t alarmFile;
+    if (fs.FileOpen(&alarmFile, "/.system/alarm.dat", LFS_O_RDONLY) != LFS_ERR_OK) {
+      NRF_LOG_WARNING("[AlarmController] No saved alarm settings");
+      return;
+    }
+    fs.FileRead(&alarmFile, reinterpret_cast<uint8_t*>(&alarmBuffer), sizeof(alarmBuffer));
+    fs.FileClose(&alarmFile);
+    if (alarmBuffer.version == alarmFormatVersion &&
+        store.Set(KeyValueStore::Key::Alarm, &alarmBuffer, sizeof(alarmBuffer)) == LFS_ERR_OK) {
+      fs.FileDelete("/.system/alarm.dat");
+    }
   }
 
-  fs.FileRead(&alarmFile, reinterpret_cast<uint8_t*>(&alarmBuffer), sizeof(alarmBuffer));
-  fs.FileClose(&alarmFile);
   if (alarmBuffer.version != alarmFormatVersion) {
     NRF_LOG_WARNING("[AlarmController] Loaded alarm settings has version %u instead of %u, discarding",
                     alarmBuffer.version,
@@ -160,22 +167,13 @@ void AlarmController::LoadSettingsFromFile() {
   }
 
   alarm = alarmBuffer;
-  NRF_LOG_INFO("[AlarmController] Loaded alarm settings from file");
+  NRF_LOG_INFO("[AlarmController] Loaded alarm settings");
 }
 
 void AlarmController::SaveSettingsToFile() const {
-  lfs_dir systemDir;
-  if (fs.DirOpen("/.system", &systemDir) != LFS_ERR_OK) {
-    fs.DirCreate("/.system");
-  }
-  fs.DirClose(&systemDir);
-  lfs_file_t alarmFile;
-  if (fs.FileOpen(&alarmFile, "/.system/alarm.dat", LFS_O_WRONLY | LFS_O_CREAT) != LFS_ERR_OK) {
-    NRF_LOG_WARNING("[AlarmController] Failed to open alarm data file for saving");
+  if (store.Set(KeyValueStore::Key::Alarm, &alarm, sizeof(alarm)) != LFS_ERR_OK) {
+    NRF_LOG_WARNING("[AlarmController] Failed to save alarm settings");
     return;
   }
-
-  fs.FileWrite(&alarmFile, reinterpret_cast<const uint8_t*>(&alarm), sizeof(alarm));
-  fs.FileClose(&alarmFile);
-  NRF_LOG_INFO("[AlarmController] Saved alarm settings with format version %u to file", alarm.version);
+  NRF_LOG_INFO("[AlarmController] Saved alarm settings with format version %u", alarm.version);
 }
@@ -21,6 +21,7 @@
 #include <timers.h>
 #include <cstdint>
 #include "components/datetime/DateTimeController.h"
+#include "components/fs/KeyValueStore.h"
 
 namespace Pinetime {
   namespace System {
@@ -82,6 +83,7 @@ namespace Pinetime {
 
       Controllers::DateTime& dateTimeController;
       Controllers::FS& fs;
+      Controllers::KeyValueStore store;
       System::SystemTask* systemTask = nullptr;
       TimerHandle_t alarmTimer;
       AlarmSettings alarm;
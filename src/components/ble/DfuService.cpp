@@ -1,4 +1,5 @@
 #include "components/ble/DfuService.h"
+#include <algorithm>
 #include <cstring>
 #include "components/ble/BleController.h"
 #include "components/ble/NotificationManager.h"
@@ -419,21 +420,14 @@ void DfuService::DfuImage::Erase() {
 }
 
 bool DfuService::DfuImage::Validate() {
-  uint32_t chunkSize = 200;
-  size_t currentOffset = 0;
-  uint16_t crc = 0;
-
-  bool first = true;
-  while (currentOffset < totalSize) {
-    uint32_t readSize = (totalSize - currentOffset) > chunkSize ? chunkSize : (totalSize - currentOffset);
-
-    spiNorFlash.Read(writeOffset + currentOffset, tempBuffer, readSize);
-    if (first) {
-      crc = ComputeCrc(tempBuffer, readSize, NULL);
-      first = false;
-    } else
-      crc = ComputeCrc(tempBuffer, readSize, &crc);
-    currentOffset += readSize;
+  // The image is read in windows of a few KB, so that the display can use the SPI bus in between
+  static constexpr size_t windowSize = 4096;
+  uint16_t crc = 0xFFFF;
+  for (size_t offset = 0; offset < totalSize; offset += windowSize) {
+    size_t size = std::min(windowSize, totalSize - offset);
+    spiNorFlash.ReadChunks(writeOffset + offset, size, tempBuffer, bufferSize, [this, &crc](const uint8_t* data, size_t chunkSize) {
+      crc = ComputeCrc(data, chunkSize, &crc);
+    });
   }
 
   return (crc == expectedCrc);
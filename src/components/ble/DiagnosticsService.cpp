@@ -0,0 +1,199 @@
+#include "components/ble/DiagnosticsService.h"
+#include "components/fs/FS.h"
+#include "systemtask/SystemTask.h"
+#include "utility/FlashTelemetry.h"
+#include "utility/Trace.h"
+#include <algorithm>
+#include <array>
+#include <iterator>
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  // 0006yyxx-78fc-48fe-8e23-433b3a1942d0
+  constexpr ble_uuid128_t CharUuid(uint8_t x, uint8_t y) {
+    return ble_uuid128_t {.u = {.type = BLE_UUID_TYPE_128},
+                          .value = {0xd0, 0x42, 0x19, 0x3a, 0x3b, 0x43, 0x23, 0x8e, 0xfe, 0x48, 0xfc, 0x78, x, y, 0x06, 0x00}};
+  }
+
+  // 00060000-78fc-48fe-8e23-433b3a1942d0
+  constexpr ble_uuid128_t BaseUuid() {
+    return CharUuid(0x00, 0x00);
+  }
+
+  constexpr ble_uuid128_t diagnosticsServiceUuid {BaseUuid()};
+  constexpr ble_uuid128_t taskStatsCharUuid {CharUuid(0x01, 0x00)};
+  constexpr ble_uuid128_t traceCharUuid {CharUuid(0x02, 0x00)};
+  constexpr ble_uuid128_t flashCharUuid {CharUuid(0x03, 0x00)};
+
+  int DiagnosticsServiceCallback(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+    auto* diagnosticsService = static_cast<DiagnosticsService*>(arg);
+    return diagnosticsService->OnDiagnosticsRequested(conn_handle, attr_handle, ctxt);
+  }
+
+  struct __attribute__((packed)) TaskStatsHeader {
+    uint32_t period;
+    uint16_t idle;
+    uint8_t nbTasks;
+  };
+
+  struct __attribute__((packed)) TaskStats {
+    char name[configMAX_TASK_NAME_LEN];
+    uint16_t load;
+    uint16_t wakeups;
+  };
+}
+
+DiagnosticsService::DiagnosticsService(Pinetime::System::SystemTask& systemTask, FS& fs)
+  : systemTask {systemTask},
+    fs {fs},
+    characteristicDefinition {{.uuid = &taskStatsCharUuid.u,
+                               .access_cb = DiagnosticsServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ,
+                               .val_handle = &taskStatsHandle},
+                              {.uuid = &traceCharUuid.u,
+                               .access_cb = DiagnosticsServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+                               .val_handle = &traceHandle},
+                              {.uuid = &flashCharUuid.u,
+                               .access_cb = DiagnosticsServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+                               .val_handle = &flashHandle},
+                              {0}},
+    serviceDefinition {
+      {.type = BLE_GATT_SVC_TYPE_PRIMARY, .uuid = &diagnosticsServiceUuid.u, .characteristics = characteristicDefinition},
+      {0},
+    } {
+}
+
+void DiagnosticsService::Init() {
+  int res = 0;
+  res = ble_gatts_count_cfg(serviceDefinition);
+  ASSERT(res == 0);
+
+  res = ble_gatts_add_svcs(serviceDefinition);
+  ASSERT(res == 0);
+}
+
+void DiagnosticsService::Reset() {
+  if (traceDumpSize > 0) {
+    Utility::Trace::Resume();
+    traceDumpSize = 0;
+  }
+}
+
+int DiagnosticsService::OnDiagnosticsRequested(uint16_t connectionHandle, uint16_t attributeHandle, ble_gatt_access_ctxt* context) {
+  if (attributeHandle == traceHandle) {
+    return OnTraceRequested(connectionHandle, context);
+  }
+  if (attributeHandle == flashHandle) {
+    return OnFlashRequested(connectionHandle, context);
+  }
+  if (context->op != BLE_GATT_ACCESS_OP_READ_CHR) {
+    return BLE_ATT_ERR_UNLIKELY;
+  }
+  if (attributeHandle == taskStatsHandle) {
+    return OnTaskStatsRequested(context);
+  }
+  return 0;
+}
+
+int DiagnosticsService::OnTaskStatsRequested(ble_gatt_access_ctxt* context) {
+  auto snapshot = systemTask.GetRunTimeStats().Latest();
+  TaskStatsHeader header {snapshot.period, snapshot.idle, snapshot.nbTasks};
+  int res = os_mbuf_append(context->om, &header, sizeof(header));
+  for (uint8_t i = 0; i < snapshot.nbTasks && res == 0; i++) {
+    const auto& task = snapshot.tasks[i];
+    TaskStats stats {};
+    std::copy(std::begin(task.name), std::end(task.name), stats.name);
+    stats.load = task.load;
+    stats.wakeups = task.wakeups;
+    res = os_mbuf_append(context->om, &stats, sizeof(stats));
+  }
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+// Writing Freeze takes a snapshot of the trace, which is then read in chunks, until an empty one.
+// The chunks are shorter than MTU - 1 bytes, so that clients don't continue with blob reads.
+int DiagnosticsService::OnTraceRequested(uint16_t connectionHandle, ble_gatt_access_ctxt* context) {
+  if (context->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+    if (OS_MBUF_PKTLEN(context->om) != 1) {
+      return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    auto command = static_cast<TraceCommands>(context->om->om_data[0]);
+    if (command == TraceCommands::Freeze) {
+      traceDumpSize = Utility::Trace::Freeze();
+      traceDumpOffset = 0;
+    } else if (command == TraceCommands::Resume) {
+      Utility::Trace::Resume();
+      traceDumpSize = 0;
+    } else {
+      return BLE_ATT_ERR_UNLIKELY;
+    }
+    return 0;
+  }
+
+  if (traceDumpOffset >= traceDumpSize) {
+    Reset();
+    return 0;
+  }
+  size_t remaining = std::min<size_t>(ble_att_mtu(connectionHandle) - 2, traceDumpSize - traceDumpOffset);
+  std::array<uint8_t, 32> buffer;
+  while (remaining > 0) {
+    size_t size = Utility::Trace::ReadDump(traceDumpOffset, buffer.data(), std::min(remaining, buffer.size()));
+    if (size == 0) {
+      break;
+    }
+    if (os_mbuf_append(context->om, buffer.data(), size) != 0) {
+      return BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+    traceDumpOffset += size;
+    remaining -= size;
+  }
+  return 0;
+}
+
+// Same protocol as the trace: writing 0x01 rewinds the dump, which is then read in chunks until an empty one
+int DiagnosticsService::OnFlashRequested(uint16_t connectionHandle, ble_gatt_access_ctxt* context) {
+  if (context->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+    if (OS_MBUF_PKTLEN(context->om) != 1) {
+      return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    if (context->om->om_data[0] != flashRewindCommand) {
+      return BLE_ATT_ERR_UNLIKELY;
+    }
+    flashTelemetrySize = Utility::FlashTelemetry::Rewind();
+    flashDumpSize = flashTelemetrySize + FS::getBlockCount();
+    flashDumpOffset = 0;
+    return 0;
+  }
+
+  if (flashDumpOffset >= flashDumpSize) {
+    flashDumpSize = 0;
+    return 0;
+  }
+  size_t remaining = std::min<size_t>(ble_att_mtu(connectionHandle) - 2, flashDumpSize - flashDumpOffset);
+  std::array<uint8_t, 32> buffer;
+  while (remaining > 0) {
+    size_t size = ReadFlashDump(flashDumpOffset, buffer.data(), std::min(remaining, buffer.size()));
+    if (size == 0) {
+      break;
+    }
+    if (os_mbuf_append(context->om, buffer.data(), size) != 0) {
+      return BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+    flashDumpOffset += size;
+    remaining -= size;
+  }
+  return 0;
+}
+
+size_t DiagnosticsService::ReadFlashDump(size_t offset, uint8_t* buffer, size_t size) {
+  if (offset < flashTelemetrySize) {
+    return Utility::FlashTelemetry::ReadDump(offset, buffer, std::min(size, flashTelemetrySize - offset));
+  }
+  return fs.ReadEraseCounts(offset - flashTelemetrySize, buffer, size);
+}
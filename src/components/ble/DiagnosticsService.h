@@ -0,0 +1,54 @@
+#pragma once
+#define min // workaround: nimble's min/max macros conflict with libstdc++
+#define max
+#include <host/ble_gap.h>
+#undef max
+#undef min
+#include <cstddef>
+
+namespace Pinetime {
+  namespace System {
+    class SystemTask;
+  }
+
+  namespace Controllers {
+    class FS;
+
+    // Read-only diagnostics of the firmware, see doc/DiagnosticsService.md
+    class DiagnosticsService {
+    public:
+      DiagnosticsService(Pinetime::System::SystemTask& systemTask, FS& fs);
+      void Init();
+      // Resumes the trace if it was left frozen by the client
+      void Reset();
+
+      int OnDiagnosticsRequested(uint16_t connectionHandle, uint16_t attributeHandle, ble_gatt_access_ctxt* context);
+
+    private:
+      enum class TraceCommands : uint8_t { Resume = 0x00, Freeze = 0x01 };
+      static constexpr uint8_t flashRewindCommand = 0x01;
+
+      int OnTaskStatsRequested(ble_gatt_access_ctxt* context);
+      int OnTraceRequested(uint16_t connectionHandle, ble_gatt_access_ctxt* context);
+      int OnFlashRequested(uint16_t connectionHandle, ble_gatt_access_ctxt* context);
+      size_t ReadFlashDump(size_t offset, uint8_t* buffer, size_t size);
+
+      Pinetime::System::SystemTask& systemTask;
+      FS& fs;
+
+      struct ble_gatt_chr_def characteristicDefinition[4];
+      struct ble_gatt_svc_def serviceDefinition[2];
+
+      uint16_t taskStatsHandle;
+      uint16_t traceHandle;
+      uint16_t flashHandle;
+      // Position of the next read in the trace dump
+      size_t traceDumpOffset = 0;
+      size_t traceDumpSize = 0;
+      // Flash telemetry, followed by the erase counts
+      size_t flashDumpOffset = 0;
+      size_t flashDumpSize = 0;
+      size_t flashTelemetrySize = 0;
+    };
+  }
+}
@@ -1,6 +1,8 @@
 #include "components/ble/MotionService.h"
 #include "components/motion/MotionController.h"
 #include "components/ble/NimbleController.h"
+#include <algorithm>
+#include <nimble/nimble_port.h>
 #include <nrf_log.h>
 
 using namespace Pinetime::Controllers;
@@ -20,11 +22,21 @@ namespace {
   constexpr ble_uuid128_t motionServiceUuid {BaseUuid()};
   constexpr ble_uuid128_t stepCountCharUuid {CharUuid(0x01, 0x00)};
   constexpr ble_uuid128_t motionValuesCharUuid {CharUuid(0x02, 0x00)};
+  constexpr ble_uuid128_t motionBatchCharUuid {CharUuid(0x03, 0x00)};
 
   int MotionServiceCallback(uint16_t /*conn_handle*/, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
     auto* motionService = static_cast<MotionService*>(arg);
     return motionService->OnStepCountRequested(attr_handle, ctxt);
   }
+
+  void FlushCallback(ble_npl_event* event) {
+    auto* motionService = static_cast<MotionService*>(ble_npl_event_get_arg(event));
+    motionService->FlushBatch();
+  }
+
+  uint32_t TicksToMs(TickType_t ticks) {
+    return static_cast<uint64_t>(ticks) * 1000 / configTICK_RATE_HZ;
+  }
 }
 
 // TODO Refactoring - remove dependency to SystemTask
@@ -41,6 +53,11 @@ MotionService::MotionService(NimbleController& nimble, Controllers::MotionContro
                                .arg = this,
                                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY,
                                .val_handle = &motionValuesHandle},
+                              {.uuid = &motionBatchCharUuid.u,
+                               .access_cb = MotionServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_NOTIFY,
+                               .val_handle = &motionBatchHandle},
                               {0}},
     serviceDefinition {
       {.type = BLE_GATT_SVC_TYPE_PRIMARY, .uuid = &motionServiceUuid.u, .characteristics = characteristicDefinition},
@@ -48,6 +65,7 @@ MotionService::MotionService(NimbleController& nimble, Controllers::MotionContro
     } {
   // TODO refactor to prevent this loop dependency (service depends on controller and controller depends on service)
   motionController.SetService(this);
+  batchMutex = xSemaphoreCreateMutex();
 }
 
 void MotionService::Init() {
@@ -57,6 +75,8 @@ void MotionService::Init() {
 
   res = ble_gatts_add_svcs(serviceDefinition);
   ASSERT(res == 0);
+
+  ble_npl_callout_init(&flushCallout, nimble_port_get_dflt_eventq(), FlushCallback, this);
 }
 
 int MotionService::OnStepCountRequested(uint16_t attributeHandle, ble_gatt_access_ctxt* context) {
@@ -73,9 +93,28 @@ int MotionService::OnStepCountRequested(uint16_t attributeHandle, ble_gatt_acces
     int res = os_mbuf_append(context->om, buffer, 3 * sizeof(int16_t));
     return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
   }
+  if (attributeHandle == motionBatchHandle) {
+    return OnBatchAccessed(context);
+  }
   return 0;
 }
 
+// The value of the batch characteristic is the maximum latency of a sample, in ms
+int MotionService::OnBatchAccessed(ble_gatt_access_ctxt* context) {
+  if (context->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+    uint16_t latency;
+    if (OS_MBUF_PKTLEN(context->om) != sizeof(latency)) {
+      return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    os_mbuf_copydata(context->om, 0, sizeof(latency), &latency);
+    maxLatency = std::clamp(latency, minMaxLatency, maxMaxLatency);
+    return 0;
+  }
+  uint16_t latency = maxLatency;
+  int res = os_mbuf_append(context->om, &latency, sizeof(latency));
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
 void MotionService::OnNewStepCountValue(uint32_t stepCount) {
   if (!stepCountNotificationEnabled) {
     return;
@@ -93,7 +132,26 @@ void MotionService::OnNewStepCountValue(uint32_t stepCount) {
   ble_gattc_notify_custom(connectionHandle, stepCountHandle, om);
 }
 
-void MotionService::OnNewMotionValues(int16_t x, int16_t y, int16_t z) {
+void MotionService::OnNewMotionValues(int16_t x, int16_t y, int16_t z, TickType_t timestamp) {
+  if (motionBatchNotificationEnabled) {
+    xSemaphoreTake(batchMutex, portMAX_DELAY);
+    // When the batch can't be sent, the oldest samples are dropped
+    if (batchCount == batch.size()) {
+      batchHead = (batchHead + 1) % batch.size();
+      batchCount--;
+    }
+    batch[(batchHead + batchCount) % batch.size()] = {timestamp, x, y, z};
+    batchCount++;
+    if (batchCount == 1) {
+      ble_npl_callout_reset(&flushCallout, ble_npl_time_ms_to_ticks32(maxLatency));
+    }
+    bool full = batchCount >= SamplesPerNotification(nimble.connHandle());
+    xSemaphoreGive(batchMutex);
+    if (full) {
+      FlushBatch();
+    }
+  }
+
   if (!motionValuesNotificationEnabled) {
     return;
   }
@@ -110,11 +168,67 @@ void MotionService::OnNewMotionValues(int16_t x, int16_t y, int16_t z) {
   ble_gattc_notify_custom(connectionHandle, motionValuesHandle, om);
 }
 
+size_t MotionService::SamplesPerNotification(uint16_t connectionHandle) const {
+  // The ATT header of a notification takes 3 bytes
+  size_t payload = ble_att_mtu(connectionHandle) - 3;
+  size_t count = payload > sizeof(BatchHeader) ? (payload - sizeof(BatchHeader)) / sizeof(BatchSample) : 0;
+  return std::clamp<size_t>(count, 1, batch.size());
+}
+
+void MotionService::FlushBatch() {
+  xSemaphoreTake(batchMutex, portMAX_DELAY);
+  ble_npl_callout_stop(&flushCallout);
+  uint16_t connectionHandle = nimble.connHandle();
+  if (!motionBatchNotificationEnabled || connectionHandle == 0 || connectionHandle == BLE_HS_CONN_HANDLE_NONE) {
+    batchCount = 0;
+    xSemaphoreGive(batchMutex);
+    return;
+  }
+
+  size_t samplesPerNotification = SamplesPerNotification(connectionHandle);
+  while (batchCount > 0) {
+    auto* om = ble_hs_mbuf_att_pkt();
+    if (om == nullptr) {
+      break;
+    }
+    uint8_t count = std::min(batchCount, samplesPerNotification);
+    BatchHeader header {batchSequence, count, TicksToMs(batch[batchHead].timestamp)};
+    bool appended = os_mbuf_append(om, &header, sizeof(header)) == 0;
+    TickType_t previous = batch[batchHead].timestamp;
+    for (size_t i = 0; i < count && appended; i++) {
+      const auto& sample = batch[(batchHead + i) % batch.size()];
+      uint16_t delta = std::min<uint32_t>(TicksToMs(sample.timestamp - previous), UINT16_MAX);
+      BatchSample packed {delta, sample.x, sample.y, sample.z};
+      appended = os_mbuf_append(om, &packed, sizeof(packed)) == 0;
+      previous = sample.timestamp;
+    }
+    if (!appended) {
+      os_mbuf_free_chain(om);
+      break;
+    }
+    // The mbuf is consumed even when the notification fails
+    if (ble_gattc_notify_custom(connectionHandle, motionBatchHandle, om) != 0) {
+      break;
+    }
+    batchSequence++;
+    batchHead = (batchHead + count) % batch.size();
+    batchCount -= count;
+  }
+
+  // Retry later when the stack is out of buffers
+  if (batchCount > 0) {
+    ble_npl_callout_reset(&flushCallout, ble_npl_time_ms_to_ticks32(maxLatency));
+  }
+  xSemaphoreGive(batchMutex);
+}
+
 void MotionService::SubscribeNotification(uint16_t attributeHandle) {
   if (attributeHandle == stepCountHandle) {
     stepCountNotificationEnabled = true;
   } else if (attributeHandle == motionValuesHandle) {
     motionValuesNotificationEnabled = true;
+  } else if (attributeHandle == motionBatchHandle) {
+    motionBatchNotificationEnabled = true;
   }
 }
 
@@ -123,5 +237,8 @@ void MotionService::UnsubscribeNotification(uint16_t attributeHandle) {
     stepCountNotificationEnabled = false;
   } else if (attributeHandle == motionValuesHandle) {
     motionValuesNotificationEnabled = false;
+  } else if (attributeHandle == motionBatchHandle) {
+    motionBatchNotificationEnabled = false;
+    FlushBatch();
   }
 }
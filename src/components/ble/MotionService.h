@@ -2,9 +2,13 @@
 #define min // workaround: nimble's min/max macros conflict with libstdc++
 #define max
 #include <host/ble_gap.h>
+#include <nimble/nimble_npl.h>
 #include <atomic>
 #undef max
 #undef min
+#include <array>
+#include <FreeRTOS.h>
+#include <semphr.h>
 
 namespace Pinetime {
   namespace Controllers {
@@ -17,22 +21,66 @@ namespace Pinetime {
       void Init();
       int OnStepCountRequested(uint16_t attributeHandle, ble_gatt_access_ctxt* context);
       void OnNewStepCountValue(uint32_t stepCount);
-      void OnNewMotionValues(int16_t x, int16_t y, int16_t z);
+      void OnNewMotionValues(int16_t x, int16_t y, int16_t z, TickType_t timestamp);
 
       void SubscribeNotification(uint16_t attributeHandle);
       void UnsubscribeNotification(uint16_t attributeHandle);
 
+      // Sends the pending batch of motion values
+      void FlushBatch();
+
     private:
+      // Batched notifications start with a BatchHeader, followed by count BatchSamples
+      struct __attribute__((packed)) BatchHeader {
+        uint8_t sequence;
+        uint8_t count;
+        uint32_t timestamp; // ms since boot, of the first sample
+      };
+
+      struct __attribute__((packed)) BatchSample {
+        uint16_t delta; // ms since the previous sample, 0 for the first one
+        int16_t x;
+        int16_t y;
+        int16_t z;
+      };
+
+      struct Sample {
+        TickType_t timestamp;
+        int16_t x;
+        int16_t y;
+        int16_t z;
+      };
+
+      static constexpr uint16_t defaultMaxLatency = 1000;
+      static constexpr uint16_t minMaxLatency = 100;
+      static constexpr uint16_t maxMaxLatency = 60000;
+      // Enough for one notification at the preferred MTU (256)
+      static constexpr size_t batchCapacity = 32;
+
+      int OnBatchAccessed(ble_gatt_access_ctxt* context);
+      size_t SamplesPerNotification(uint16_t connectionHandle) const;
+
       NimbleController& nimble;
       Controllers::MotionController& motionController;
 
-      struct ble_gatt_chr_def characteristicDefinition[3];
+      struct ble_gatt_chr_def characteristicDefinition[4];
       struct ble_gatt_svc_def serviceDefinition[2];
 
       uint16_t stepCountHandle;
       uint16_t motionValuesHandle;
+      uint16_t motionBatchHandle;
       std::atomic_bool stepCountNotificationEnabled {false};
       std::atomic_bool motionValuesNotificationEnabled {false};
+      std::atomic_bool motionBatchNotificationEnabled {false};
+
+      // The batch is filled by SystemTask and sent by the BLE host task
+      SemaphoreHandle_t batchMutex;
+      ble_npl_callout flushCallout;
+      std::array<Sample, batchCapacity> batch;
+      size_t batchHead = 0;
+      size_t batchCount = 0;
+      uint8_t batchSequence = 0;
+      std::atomic<uint16_t> maxLatency {defaultMaxLatency};
     };
   }
 }
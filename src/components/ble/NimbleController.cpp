@@ -1,4 +1,6 @@
 #include "components/ble/NimbleController.h"
+#include <algorithm>
+#include <cstddef>
 #include <cstring>
 
 #include <nrf_log.h>
@@ -19,9 +21,22 @@
 #include "components/datetime/DateTimeController.h"
 #include "components/fs/FS.h"
 #include "systemtask/SystemTask.h"
+#include "utility/Trace.h"
 
 using namespace Pinetime::Controllers;
 
+namespace {
+  // Saved in the key-value store, only the CCCDs in use are saved
+  struct Bond {
+    ble_store_value_sec ourSec;
+    ble_store_value_sec peerSec;
+    uint8_t cccdCount;
+    ble_store_value_cccd cccds[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)];
+  };
+
+  static_assert(sizeof(Bond) <= KeyValueStore::maxValueSize);
+}
+
 NimbleController::NimbleController(Pinetime::System::SystemTask& systemTask,
                                    Ble& bleController,
                                    DateTime& dateTimeController,
@@ -37,6 +52,7 @@ NimbleController::NimbleController(Pinetime::System::SystemTask& systemTask,
     notificationManager {notificationManager},
     spiNorFlash {spiNorFlash},
     fs {fs},
+    store {fs},
     dfuService {systemTask, bleController, spiNorFlash},
     fsService {systemTask, fs},
 
@@ -53,6 +69,7 @@ NimbleController::NimbleController(Pinetime::System::SystemTask& systemTask,
     heartRateService {*this, heartRateController},
     motionService {*this, motionController},
     praxiomService {},
+    diagnosticsService {systemTask, fs},
     serviceDiscovery({&currentTimeClient, &alertNotificationClient}) {
 }
 
@@ -103,6 +120,7 @@ void NimbleController::Init() {
   motionService.Init();
   fsService.Init();
   praxiomService.Init();
+  diagnosticsService.Init();
 
   int rc;
   rc = ble_hs_util_ensure_addr(0);
@@ -187,6 +205,7 @@ void NimbleController::StartAdvertising() {
 }
 
 int NimbleController::OnGAPEvent(ble_gap_event* event) {
+  Utility::Trace::Record(Utility::Trace::Event::BleGapEvent, event->type);
   switch (event->type) {
     case BLE_GAP_EVENT_ADV_COMPLETE:
       NRF_LOG_INFO("Advertising event : BLE_GAP_EVENT_ADV_COMPLETE");
@@ -228,6 +247,7 @@ int NimbleController::OnGAPEvent(ble_gap_event* event) {
 
       currentTimeClient.Reset();
       alertNotificationClient.Reset();
+      diagnosticsService.Reset();
       connectionHandle = BLE_HS_CONN_HANDLE_NONE;
       if (bleController.IsConnected()) {
         bleController.Disconnect();
@@ -427,7 +447,8 @@ void NimbleController::DisableRadio() {
 
 void NimbleController::PersistBond(struct ble_gap_conn_desc& desc) {
   union ble_store_key key;
-  union ble_store_value our_sec, peer_sec, peer_cccd_set[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)] = {0};
+  union ble_store_value our_sec, peer_sec;
+  Bond bond {};
   int rc;
 
   memset(&key, 0, sizeof key);
@@ -451,41 +472,35 @@ void NimbleController::PersistBond(struct ble_gap_conn_desc& desc) {
     key.cccd.peer_addr = desc.peer_id_addr;
     int peer_count = 0;
     ble_store_util_count(BLE_STORE_OBJ_TYPE_CCCD, &peer_count);
+    peer_count = std::min<int>(peer_count, MYNEWT_VAL(BLE_STORE_MAX_CCCDS));
     for (int i = 0; i < peer_count; i++) {
       key.cccd.idx = peer_count;
-      ble_store_read_cccd(&key.cccd, &peer_cccd_set[i].cccd);
+      ble_store_read_cccd(&key.cccd, &bond.cccds[i]);
     }
+    bond.ourSec = our_sec.sec;
+    bond.peerSec = peer_sec.sec;
+    bond.cccdCount = peer_count;
 
-    /* Wakeup Spi and SpiNorFlash before accessing the file system
-     * This should be fixed in the FS driver
-     */
-    systemTask.PushMessage(Pinetime::System::Messages::DisableSleeping);
-
-    // This isn't quite correct
-    // SystemTask could receive EnableSleeping right after passing this check
-    // We need some guarantee that the SystemTask has processed the above message
-    // before we can continue
-    while (!systemTask.IsSleepDisabled()) {
-      vTaskDelay(pdMS_TO_TICKS(5));
-    }
-
-    lfs_file_t file_p;
-
-    rc = fs.FileOpen(&file_p, "/bond.dat", LFS_O_WRONLY | LFS_O_CREAT);
-    if (rc == 0) {
-      fs.FileWrite(&file_p, reinterpret_cast<uint8_t*>(&our_sec.sec), sizeof our_sec);
-      fs.FileWrite(&file_p, reinterpret_cast<uint8_t*>(&peer_sec.sec), sizeof peer_sec);
-      fs.FileWrite(&file_p, reinterpret_cast<const uint8_t*>(&peer_count), 1);
-      for (int i = 0; i < peer_count; i++) {
-        fs.FileWrite(&file_p, reinterpret_cast<uint8_t*>(&peer_cccd_set[i].cccd), sizeof(struct ble_store_value_cccd));
-      }
-      fs.FileClose(&file_p);
-    }
-    systemTask.PushMessage(Pinetime::System::Messages::EnableSleeping);
+    // The file system powers the flash up by itself when the watch sleeps
+    store.Set(KeyValueStore::Key::Bond, &bond, offsetof(Bond, cccds) + peer_count * sizeof(ble_store_value_cccd));
   }
 }
 
 void NimbleController::RestoreBond() {
+  Bond bond;
+  int size = store.Get(KeyValueStore::Key::Bond, &bond, sizeof(bond));
+  if (size >= static_cast<int>(offsetof(Bond, cccds))) {
+    ble_store_write_our_sec(&bond.ourSec);
+    ble_store_write_peer_sec(&bond.peerSec);
+    uint8_t count = std::min<size_t>(bond.cccdCount, (size - offsetof(Bond, cccds)) / sizeof(ble_store_value_cccd));
+    for (uint8_t i = 0; i < count; i++) {
+      ble_store_write_cccd(&bond.cccds[i]);
+    }
+    store.Remove(KeyValueStore::Key::Bond);
+    return;
+  }
+
+  // Bond saved to a file by previous versions
   lfs_file_t file_p;
   union ble_store_value sec, cccd;
   uint8_t peer_count = 0;
@@ -14,6 +14,7 @@
 #include "CurrentTimeClient.h"
 #include "CurrentTimeService.h"
 #include "DeviceInformationService.h"
+#include "DiagnosticsService.h"
 #include "DfuService.h"
 #include "FSService.h"
 #include "HeartRateService.h"
@@ -24,6 +25,7 @@
 #include "ServiceDiscovery.h"
 #include "SimpleWeatherService.h"
 #include "PraxiomService.h"  // ← ADDED
+#include "components/fs/KeyValueStore.h"
 
 namespace Pinetime {
   namespace Drivers {
@@ -127,6 +129,7 @@ namespace Pinetime {
       NotificationManager& notificationManager;
       Pinetime::Drivers::SpiNorFlash& spiNorFlash;
       Controllers::FS& fs;
+      Controllers::KeyValueStore store;
       Pinetime::Controllers::DfuService dfuService;
       Pinetime::Controllers::FSService fsService;
 
@@ -143,6 +146,7 @@ namespace Pinetime {
       HeartRateService heartRateService;
       MotionService motionService;  // ← ADDED
       PraxiomService praxiomService;  // ← ADDED
+      DiagnosticsService diagnosticsService;
       ServiceDiscovery serviceDiscovery;
 
       uint8_t addrType;
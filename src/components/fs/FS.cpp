@@ -1,7 +1,13 @@
 #include "components/fs/FS.h"
+#include <algorithm>
 #include <cstring>
+#include <task.h>
+#include <libraries/log/nrf_log.h>
 #include <littlefs/lfs.h>
 #include <lvgl/lvgl.h>
+#include "drivers/SpiMaster.h"
+#include "utility/FlashTelemetry.h"
+#include "utility/Trace.h"
 
 using namespace Pinetime::Controllers;
 
@@ -20,16 +26,20 @@ FS::FS(Pinetime::Drivers::SpiNorFlash& driver)
       .block_count = size / blockSize,
       .block_cycles = 1000u,
 
-      .cache_size = 16,
-      .lookahead_size = 16,
+      .cache_size = FS_CACHE_SIZE,
+      .lookahead_size = FS_LOOKAHEAD_SIZE,
+      .read_buffer = readBuffer.data(),
+      .prog_buffer = progBuffer.data(),
+      .lookahead_buffer = lookaheadBuffer.data(),
 
       .name_max = 50,
-      .attr_max = 50,
+      .attr_max = maxAttributeSize,
     } {
+  mutex = xSemaphoreCreateMutex();
 }
 
 void FS::Init() {
-
+  Lock();
   // try mount
   int err = lfs_mount(&lfs, &lfsConfig);
 
@@ -39,9 +49,12 @@ void FS::Init() {
     lfs_format(&lfs, &lfsConfig);
     err = lfs_mount(&lfs, &lfsConfig);
     if (err != LFS_ERR_OK) {
+      Unlock();
       return;
     }
   }
+  Unlock();
+  LoadEraseCounts();
 
 #ifndef PINETIME_IS_RECOVERY
   VerifyResource();
@@ -53,60 +66,425 @@ void FS::VerifyResource() {
   resourcesValid = true;
 }
 
+// Waits for the lock, and accounts for the time spent waiting when it is taken by another task.
+// Wakes the flash up when the watch sleeps.
+void FS::Lock() {
+  if (xSemaphoreTake(mutex, 0) != pdTRUE) {
+    TickType_t start = xTaskGetTickCount();
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    uint32_t waited = static_cast<uint64_t>(xTaskGetTickCount() - start) * 1000 / configTICK_RATE_HZ;
+    statistics.lockContentions++;
+    statistics.lockWaitMs += waited;
+    statistics.lockMaxWaitMs = std::max(statistics.lockMaxWaitMs, waited);
+  }
+  if (sleeping && !powered) {
+    PowerUp();
+  }
+}
+
+void FS::Unlock() {
+  if (sleeping && powered && holds == 0) {
+    PowerDown();
+  }
+  xSemaphoreGive(mutex);
+}
+
+void FS::Sleep(bool powerDownFlash, Pinetime::Drivers::SpiMaster* bus) {
+  Lock();
+  flashPoweredDown = powerDownFlash;
+  sleepingBus = bus;
+  sleeping = true;
+  powered = true;
+  Unlock();
+}
+
+void FS::Wakeup() {
+  Lock();
+  sleeping = false;
+  Unlock();
+}
+
+void FS::HoldFlash() {
+  Lock();
+  holds++;
+  Unlock();
+}
+
+void FS::ReleaseFlash() {
+  Lock();
+  holds--;
+  Unlock();
+}
+
+void FS::PowerUp() {
+  if (sleepingBus != nullptr) {
+    sleepingBus->Wakeup();
+  }
+  if (flashPoweredDown) {
+    flashDriver.Wakeup();
+  }
+  powered = true;
+}
+
+void FS::PowerDown() {
+  if (flashPoweredDown) {
+    flashDriver.Sleep();
+  }
+  if (sleepingBus != nullptr) {
+    sleepingBus->Sleep();
+  }
+  powered = false;
+}
+
+template <class Function>
+int FS::Locked(Utility::Trace::FsOperation operation, uint32_t size, Function&& function) {
+  Lock();
+  Utility::Trace::Record(Utility::Trace::Event::FsStart, (size << 8) | static_cast<uint8_t>(operation));
+  int result = function();
+  Utility::Trace::Record(Utility::Trace::Event::FsEnd, result);
+  Unlock();
+  return result;
+}
+
+FS::Statistics FS::GetStatistics() {
+  Lock();
+  Statistics copy = statistics;
+  Unlock();
+  return copy;
+}
+
+// The littlefs file used for the handle of the caller
+lfs_file_t* FS::Resolve(lfs_file_t* file_p) {
+  for (auto& entry : cache) {
+    if (entry.user == file_p) {
+      return &entry.file;
+    }
+  }
+  return file_p;
+}
+
+// Read-only files stay open in the cache when they are closed, and are reused when the same path is opened again.
+// The handle of the caller only stands for the cached file, and is redirected to it until closed.
+int FS::OpenCached(lfs_file_t* file_p, const char* path) {
+  if (std::strlen(path) > maxCachedPathLength) {
+    return lfs_file_open(&lfs, file_p, path, LFS_O_RDONLY);
+  }
+  CachedFile* victim = nullptr;
+  for (auto& entry : cache) {
+    if (entry.user != nullptr) {
+      continue;
+    }
+    if (entry.open && std::strcmp(entry.path, path) == 0) {
+      statistics.cacheHits++;
+      return Attach(entry, file_p);
+    }
+    // Free entries first, then the least recently used
+    if (victim == nullptr || (victim->open && (!entry.open || entry.lastUse < victim->lastUse))) {
+      victim = &entry;
+    }
+  }
+  statistics.cacheMisses++;
+  if (victim == nullptr) {
+    return lfs_file_open(&lfs, file_p, path, LFS_O_RDONLY);
+  }
+  if (victim->open) {
+    lfs_file_close(&lfs, &victim->file);
+    victim->open = false;
+  }
+  victim->config = {};
+  victim->config.buffer = victim->buffer.data();
+  int res = lfs_file_opencfg(&lfs, &victim->file, path, LFS_O_RDONLY, &victim->config);
+  if (res != LFS_ERR_OK) {
+    return res;
+  }
+  victim->open = true;
+  victim->stale = false;
+  std::strcpy(victim->path, path);
+  return Attach(*victim, file_p);
+}
+
+int FS::Attach(CachedFile& entry, lfs_file_t* file_p) {
+  entry.user = file_p;
+  entry.lastUse = ++useCounter;
+  // Callers may check the type of the file they opened
+  std::memset(file_p, 0, sizeof(lfs_file_t));
+  file_p->type = entry.file.type;
+  return LFS_ERR_OK;
+}
+
+// Closes the cached files of path, before it is modified. A cached file still in use is closed when its user closes it.
+void FS::Invalidate(const char* path) {
+  for (auto& entry : cache) {
+    if (!entry.open || std::strcmp(entry.path, path) != 0) {
+      continue;
+    }
+    if (entry.user == nullptr) {
+      lfs_file_close(&lfs, &entry.file);
+      entry.open = false;
+    } else {
+      entry.stale = true;
+    }
+  }
+}
+
 int FS::FileOpen(lfs_file_t* file_p, const char* fileName, const int flags) {
-  return lfs_file_open(&lfs, file_p, fileName, flags);
+  return Locked(Utility::Trace::FsOperation::FileOpen, 0, [&]() {
+    // The handle of the caller may still stand for a cached file that was not closed
+    for (auto& entry : cache) {
+      if (entry.user == file_p) {
+        entry.user = nullptr;
+      }
+    }
+    if (flags == LFS_O_RDONLY) {
+      return OpenCached(file_p, fileName);
+    }
+    Invalidate(fileName);
+    return lfs_file_open(&lfs, file_p, fileName, flags);
+  });
 }
 
 int FS::FileClose(lfs_file_t* file_p) {
-  return lfs_file_close(&lfs, file_p);
+  return Locked(Utility::Trace::FsOperation::FileClose, 0, [&]() {
+    for (auto& entry : cache) {
+      if (entry.user != file_p) {
+        continue;
+      }
+      entry.user = nullptr;
+      if (entry.stale) {
+        entry.open = false;
+        return lfs_file_close(&lfs, &entry.file);
+      }
+      return lfs_file_rewind(&lfs, &entry.file);
+    }
+    return lfs_file_close(&lfs, file_p);
+  });
 }
 
 int FS::FileRead(lfs_file_t* file_p, uint8_t* buff, uint32_t size) {
-  return lfs_file_read(&lfs, file_p, buff, size);
+  return Locked(Utility::Trace::FsOperation::FileRead, size, [&]() {
+    return lfs_file_read(&lfs, Resolve(file_p), buff, size);
+  });
 }
 
 int FS::FileWrite(lfs_file_t* file_p, const uint8_t* buff, uint32_t size) {
-  return lfs_file_write(&lfs, file_p, buff, size);
+  return Locked(Utility::Trace::FsOperation::FileWrite, size, [&]() {
+    return lfs_file_write(&lfs, Resolve(file_p), buff, size);
+  });
 }
 
 int FS::FileSeek(lfs_file_t* file_p, uint32_t pos) {
-  return lfs_file_seek(&lfs, file_p, pos, LFS_SEEK_SET);
+  return Locked(Utility::Trace::FsOperation::FileSeek, 0, [&]() {
+    return lfs_file_seek(&lfs, Resolve(file_p), pos, LFS_SEEK_SET);
+  });
 }
 
 int FS::FileDelete(const char* fileName) {
-  return lfs_remove(&lfs, fileName);
+  return Locked(Utility::Trace::FsOperation::FileDelete, 0, [&]() {
+    Invalidate(fileName);
+    return lfs_remove(&lfs, fileName);
+  });
 }
 
 int FS::DirOpen(const char* path, lfs_dir_t* lfs_dir) {
-  return lfs_dir_open(&lfs, lfs_dir, path);
+  return Locked(Utility::Trace::FsOperation::DirOpen, 0, [&]() {
+    return lfs_dir_open(&lfs, lfs_dir, path);
+  });
 }
 
 int FS::DirClose(lfs_dir_t* lfs_dir) {
-  return lfs_dir_close(&lfs, lfs_dir);
+  return Locked(Utility::Trace::FsOperation::DirClose, 0, [&]() {
+    return lfs_dir_close(&lfs, lfs_dir);
+  });
 }
 
 int FS::DirRead(lfs_dir_t* dir, lfs_info* info) {
-  return lfs_dir_read(&lfs, dir, info);
+  return Locked(Utility::Trace::FsOperation::DirRead, 0, [&]() {
+    return lfs_dir_read(&lfs, dir, info);
+  });
 }
 
 int FS::DirRewind(lfs_dir_t* dir) {
-  return lfs_dir_rewind(&lfs, dir);
+  return Locked(Utility::Trace::FsOperation::DirRewind, 0, [&]() {
+    return lfs_dir_rewind(&lfs, dir);
+  });
 }
 
 int FS::DirCreate(const char* path) {
-  return lfs_mkdir(&lfs, path);
+  return Locked(Utility::Trace::FsOperation::DirCreate, 0, [&]() {
+    return lfs_mkdir(&lfs, path);
+  });
 }
 
 int FS::Rename(const char* oldPath, const char* newPath) {
-  return lfs_rename(&lfs, oldPath, newPath);
+  return Locked(Utility::Trace::FsOperation::Rename, 0, [&]() {
+    Invalidate(oldPath);
+    Invalidate(newPath);
+    return lfs_rename(&lfs, oldPath, newPath);
+  });
 }
 
 int FS::Stat(const char* path, lfs_info* info) {
-  return lfs_stat(&lfs, path, info);
+  return Locked(Utility::Trace::FsOperation::Stat, 0, [&]() {
+    return lfs_stat(&lfs, path, info);
+  });
+}
+
+int FS::GetAttribute(const char* path, uint8_t type, void* buffer, uint32_t size) {
+  return Locked(Utility::Trace::FsOperation::GetAttribute, size, [&]() {
+    return lfs_getattr(&lfs, path, type, buffer, size);
+  });
+}
+
+// The attributes of a file opened for writing are committed with the metadata of the file when it is closed
+int FS::SetAttributes(const char* path, lfs_attr* attributes, size_t count) {
+  return Locked(Utility::Trace::FsOperation::SetAttributes, count, [&]() {
+    Invalidate(path);
+    lfs_file_config config {};
+    config.attrs = attributes;
+    config.attr_count = count;
+    lfs_file_t file;
+    int res = lfs_file_opencfg(&lfs, &file, path, LFS_O_WRONLY | LFS_O_CREAT, &config);
+    if (res != LFS_ERR_OK) {
+      return res;
+    }
+    return lfs_file_close(&lfs, &file);
+  });
+}
+
+int FS::RemoveAttribute(const char* path, uint8_t type) {
+  return Locked(Utility::Trace::FsOperation::RemoveAttribute, 0, [&]() {
+    return lfs_removeattr(&lfs, path, type);
+  });
 }
 
 lfs_ssize_t FS::GetFSSize() {
-  return lfs_fs_size(&lfs);
+  Lock();
+  lfs_ssize_t size = lfs_fs_size(&lfs);
+  Unlock();
+  return size;
+}
+
+// Free blocks are found by traversing the file system, under the lock: littlefs can't allocate one while it is erased
+bool FS::PreErase() {
+  Lock();
+  if (erasedBlocks.count() >= preErasedBlocks) {
+    Unlock();
+    return false;
+  }
+  if (!usedBlocksValid) {
+    usedBlocks.reset();
+    auto markUsed = [](void* data, lfs_block_t block) -> int {
+      static_cast<std::bitset<blockCount>*>(data)->set(block);
+      return 0;
+    };
+    if (lfs_fs_traverse(&lfs, markUsed, &usedBlocks) != LFS_ERR_OK) {
+      Unlock();
+      return false;
+    }
+    usedBlocksValid = true;
+  }
+
+  bool erased = false;
+  for (size_t i = 1; i <= blockCount; i++) {
+    lfs_block_t block = (allocationCursor + i) % blockCount;
+    if (usedBlocks.test(block) || erasedBlocks.test(block)) {
+      continue;
+    }
+    const size_t address = startAddress + (block * blockSize);
+    InvalidateReadAhead(address, blockSize);
+    flashDriver.SectorErase(address);
+    CountErase(block);
+    if (!flashDriver.EraseFailed()) {
+      erasedBlocks.set(block);
+      statistics.preErases++;
+      erased = true;
+    }
+    break;
+  }
+  Unlock();
+  return erased;
+}
+
+FS::Wear FS::GetWear() {
+  Wear wear {};
+  Lock();
+  for (uint8_t code : eraseCounts) {
+    uint32_t count = EraseCount(code);
+    wear.erases += count;
+    wear.maxErases = std::max(wear.maxErases, count);
+  }
+  Unlock();
+  return wear;
+}
+
+size_t FS::ReadEraseCounts(size_t offset, uint8_t* buffer, size_t size) {
+  if (offset >= eraseCounts.size()) {
+    return 0;
+  }
+  size = std::min(size, eraseCounts.size() - offset);
+  std::memcpy(buffer, eraseCounts.data() + offset, size);
+  return size;
+}
+
+uint32_t FS::EraseCount(uint8_t code) {
+  uint32_t exponent = code >> 4;
+  uint32_t mantissa = code & 0x0F;
+  return exponent == 0 ? mantissa : (16 + mantissa) << (exponent - 1);
+}
+
+// Past 16 erases, the code of a block is incremented with a probability of 1 / the difference between the counts of
+// the next code and the current one: the expected value of the count is the number of erases
+void FS::CountErase(lfs_block_t block) {
+  erasesSinceSave++;
+  uint8_t code = eraseCounts[block];
+  if (code == UINT8_MAX) {
+    return;
+  }
+  uint32_t exponent = code >> 4;
+  uint32_t step = exponent == 0 ? 1 : 1u << (exponent - 1);
+  eraseCountRandom ^= eraseCountRandom << 13;
+  eraseCountRandom ^= eraseCountRandom >> 17;
+  eraseCountRandom ^= eraseCountRandom << 5;
+  if ((eraseCountRandom & (step - 1)) == 0) {
+    eraseCounts[block] = code + 1;
+  }
+}
+
+void FS::LoadEraseCounts() {
+  lfs_file_t file;
+  if (FileOpen(&file, eraseCountsPath, LFS_O_RDONLY) != LFS_ERR_OK) {
+    return;
+  }
+  // Read in place: called by Init(), before the other tasks use the file system. A copy would take 844 bytes of stack.
+  uint8_t version = 0;
+  if (FileRead(&file, &version, sizeof(version)) == static_cast<int>(sizeof(version)) && version == eraseCountsVersion) {
+    if (FileRead(&file, eraseCounts.data(), eraseCounts.size()) != static_cast<int>(eraseCounts.size())) {
+      eraseCounts.fill(0);
+    }
+  }
+  FileClose(&file);
+}
+
+// Saving the counts erases blocks too, they are counted in the next save
+void FS::SaveEraseCounts() {
+  if (erasesSinceSave < eraseCountsSavePeriod) {
+    return;
+  }
+  Lock();
+  erasesSinceSave = 0;
+  Unlock();
+
+  DirCreate("/.system");
+  lfs_file_t file;
+  if (FileOpen(&file, eraseCountsPath, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) != LFS_ERR_OK) {
+    NRF_LOG_WARNING("[FS] Could not save the erase counts");
+    return;
+  }
+  uint8_t version = eraseCountsVersion;
+  FileWrite(&file, &version, sizeof(version));
+  // Written in place: the erases of this write may or may not be counted in it
+  FileWrite(&file, eraseCounts.data(), eraseCounts.size());
+  FileClose(&file);
 }
 
 /*
@@ -114,27 +492,81 @@ lfs_ssize_t FS::GetFSSize() {
     ----------- Interface between littlefs and SpiNorFlash -----------
 
 */
-int FS::SectorSync(const struct lfs_config* /*c*/) {
-  return 0;
+// The programs are queued by SectorProg(), littlefs only relies on them once it synced
+int FS::SectorSync(const struct lfs_config* c) {
+  Pinetime::Controllers::FS& lfs = *(static_cast<Pinetime::Controllers::FS*>(c->context));
+  uint32_t start = Utility::FlashTelemetry::Start();
+  bool synced = lfs.flashDriver.Sync();
+  Utility::FlashTelemetry::Record(Utility::FlashTelemetry::Operation::BlockSync, start);
+  return synced ? 0 : -1;
 }
 
 int FS::SectorErase(const struct lfs_config* c, lfs_block_t block) {
   Pinetime::Controllers::FS& lfs = *(static_cast<Pinetime::Controllers::FS*>(c->context));
+  lfs.usedBlocksValid = false;
+  lfs.allocationCursor = block;
+  uint32_t start = Utility::FlashTelemetry::Start();
+  if (lfs.erasedBlocks.test(block)) {
+    lfs.erasedBlocks.reset(block);
+    lfs.statistics.erasesSkipped++;
+    Utility::FlashTelemetry::Record(Utility::FlashTelemetry::Operation::BlockErase, start);
+    return 0;
+  }
   const size_t address = startAddress + (block * blockSize);
+  lfs.InvalidateReadAhead(address, blockSize);
   lfs.flashDriver.SectorErase(address);
+  lfs.CountErase(block);
+  Utility::FlashTelemetry::Record(Utility::FlashTelemetry::Operation::BlockErase, start, blockSize);
   return lfs.flashDriver.EraseFailed() ? -1 : 0;
 }
 
 int FS::SectorProg(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, const void* buffer, lfs_size_t size) {
   Pinetime::Controllers::FS& lfs = *(static_cast<Pinetime::Controllers::FS*>(c->context));
   const size_t address = startAddress + (block * blockSize) + off;
-  lfs.flashDriver.Write(address, (uint8_t*) buffer, size);
-  return lfs.flashDriver.ProgramFailed() ? -1 : 0;
+  lfs.usedBlocksValid = false;
+  lfs.erasedBlocks.reset(block);
+  lfs.InvalidateReadAhead(address, size);
+  uint32_t start = Utility::FlashTelemetry::Start();
+  lfs.flashDriver.Program(address, static_cast<const uint8_t*>(buffer), size);
+  Utility::FlashTelemetry::Record(Utility::FlashTelemetry::Operation::BlockProg, start, size);
+  return 0;
 }
 
 int FS::SectorRead(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, void* buffer, lfs_size_t size) {
   Pinetime::Controllers::FS& lfs = *(static_cast<Pinetime::Controllers::FS*>(c->context));
   const size_t address = startAddress + (block * blockSize) + off;
-  lfs.flashDriver.Read(address, static_cast<uint8_t*>(buffer), size);
+  uint32_t start = Utility::FlashTelemetry::Start();
+  lfs.ReadFlash(address, static_cast<uint8_t*>(buffer), size);
+  Utility::FlashTelemetry::Record(Utility::FlashTelemetry::Operation::BlockRead, start, size);
   return 0;
 }
+
+// When littlefs streams a file, it reads it one cache at a time: a small read following the previous one
+// reads the next bytes of the block too, so that the following reads don't need a SPI transaction
+void FS::ReadFlash(size_t address, uint8_t* buffer, size_t size) {
+  bool sequential = address == lastReadEnd;
+  lastReadEnd = address + size;
+  if (address >= readAheadAddress && address + size <= readAheadAddress + readAheadLength) {
+    std::memcpy(buffer, readAhead.data() + (address - readAheadAddress), size);
+    statistics.readAheadHits++;
+    return;
+  }
+
+  statistics.flashReads++;
+  size_t blockEnd = address - (address - startAddress) % blockSize + blockSize;
+  size_t length = std::min(readAhead.size(), blockEnd - address);
+  if (!sequential || size >= length) {
+    flashDriver.Read(address, buffer, size);
+    return;
+  }
+  flashDriver.Read(address, readAhead.data(), length);
+  readAheadAddress = address;
+  readAheadLength = length;
+  std::memcpy(buffer, readAhead.data(), size);
+}
+
+void FS::InvalidateReadAhead(size_t address, size_t size) {
+  if (address < readAheadAddress + readAheadLength && readAheadAddress < address + size) {
+    readAheadLength = 0;
+  }
+}
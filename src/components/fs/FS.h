@@ -1,13 +1,55 @@
 #pragma once
 
+#include <array>
+#include <bitset>
 #include <cstdint>
+#include <FreeRTOS.h>
+#include <semphr.h>
 #include "drivers/SpiNorFlash.h"
+#include "utility/Trace.h"
 #include <littlefs/lfs.h>
 
+// Caches of littlefs, in bytes: larger caches turn the many small reads of littlefs into fewer, larger SPI transactions.
+// The cache size is used for the read and program caches, and for the cache of each open file.
+// It must be a multiple of 16 and divide the block size.
+#ifndef FS_CACHE_SIZE
+  #define FS_CACHE_SIZE 256
+#endif
+// Blocks tracked by the block allocator in one pass, divided by 8
+#ifndef FS_LOOKAHEAD_SIZE
+  #define FS_LOOKAHEAD_SIZE 64
+#endif
+// Read-ahead of the sequential reads of the block device, 0 to disable it
+#ifndef FS_READ_AHEAD_SIZE
+  #define FS_READ_AHEAD_SIZE 256
+#endif
+
 namespace Pinetime {
+  namespace Drivers {
+    class SpiMaster;
+  }
+
   namespace Controllers {
+    // The file system, on the external flash. Safe to use from several tasks: littlefs is only called under a mutex.
     class FS {
     public:
+      struct Statistics {
+        uint32_t cacheHits;
+        uint32_t cacheMisses;
+        uint32_t lockContentions; // number of operations that waited for another task
+        uint32_t lockWaitMs;
+        uint32_t lockMaxWaitMs;
+        uint32_t readAheadHits; // block device reads served from the read-ahead buffer
+        uint32_t flashReads;    // block device reads sent to the flash
+        uint32_t preErases;     // blocks erased ahead of time by PreErase()
+        uint32_t erasesSkipped; // erases requested by littlefs on blocks already erased
+      };
+
+      struct Wear {
+        uint32_t erases;    // of all the blocks, since the erase counts were first saved
+        uint32_t maxErases; // of the most erased block
+      };
+
       FS(Pinetime::Drivers::SpiNorFlash&);
 
       void Init();
@@ -29,7 +71,33 @@ namespace Pinetime {
       lfs_ssize_t GetFSSize();
       int Rename(const char* oldPath, const char* newPath);
       int Stat(const char* path, lfs_info* info);
+      // Custom attributes of a file, at most maxAttributeSize bytes each
+      int GetAttribute(const char* path, uint8_t type, void* buffer, uint32_t size);
+      // Writes the attributes in a single commit, creating the file if needed
+      int SetAttributes(const char* path, lfs_attr* attributes, size_t count);
+      int RemoveAttribute(const char* path, uint8_t type);
       void VerifyResource();
+      Statistics GetStatistics();
+      // Erases a free block ahead of time, the next one littlefs is likely to allocate, unless enough blocks are already
+      // erased. littlefs then allocates it without waiting for an erase. Returns false when there is nothing left to do.
+      // Holds the file system for the duration of an erase (about 50ms): only call it when the watch is idle.
+      bool PreErase();
+      Wear GetWear();
+      // Copies the erase counts of the blocks from offset, as 8 bits codes, see EraseCount()
+      size_t ReadEraseCounts(size_t offset, uint8_t* buffer, size_t size);
+      // Saves the erase counts when enough blocks were erased since they were last saved
+      void SaveEraseCounts();
+      // Puts the flash in deep power down, and the SPI bus to sleep when it is given. Until Wakeup() is called, each
+      // operation wakes them up for its duration: the tasks running while the watch sleeps can still use the file system.
+      // Waits for the operation in progress.
+      void Sleep(bool powerDownFlash, Pinetime::Drivers::SpiMaster* bus);
+      void Wakeup();
+      // Keeps the flash and the bus powered between the operations of a sequence while the watch sleeps, until
+      // ReleaseFlash(): a sequence of small writes then wakes the flash up once instead of once per operation
+      void HoldFlash();
+      void ReleaseFlash();
+      // The erase counts are 8 bits floats: 4 bits of exponent, 4 bits of mantissa, up to 507904 erases
+      static uint32_t EraseCount(uint8_t code);
 
       static size_t getSize() {
         return size;
@@ -39,7 +107,43 @@ namespace Pinetime {
         return blockSize;
       }
 
+      static size_t getBlockCount() {
+        return blockCount;
+      }
+
+      // Stored in the superblock when the FS is formatted, it can't be changed without formatting again
+      static constexpr size_t maxAttributeSize = 50;
+
     private:
+      // A read-only file kept open after it was closed, see OpenCached()
+      struct CachedFile {
+        lfs_file_t file;
+        lfs_file_config config;
+        std::array<uint8_t, FS_CACHE_SIZE> buffer;
+        lfs_file_t* user = nullptr; // handle of the caller while the file is open, nullptr when available
+        bool open = false;
+        bool stale = false; // modified while in use, closed when the user closes it
+        uint32_t lastUse = 0;
+        char path[32];
+      };
+      static constexpr size_t maxCachedPathLength = sizeof(CachedFile::path) - 1;
+      static constexpr size_t cachedFiles = 2;
+
+      void Lock();
+      void Unlock();
+      template <class Function>
+      int Locked(Utility::Trace::FsOperation operation, uint32_t size, Function&& function);
+      lfs_file_t* Resolve(lfs_file_t* file_p);
+      int OpenCached(lfs_file_t* file_p, const char* path);
+      int Attach(CachedFile& entry, lfs_file_t* file_p);
+      void Invalidate(const char* path);
+      void ReadFlash(size_t address, uint8_t* buffer, size_t size);
+      void InvalidateReadAhead(size_t address, size_t size);
+      void LoadEraseCounts();
+      void CountErase(lfs_block_t block);
+      void PowerUp();
+      void PowerDown();
+
       Pinetime::Drivers::SpiNorFlash& flashDriver;
 
       /*
@@ -67,12 +171,51 @@ namespace Pinetime {
       static constexpr size_t startAddress = 0x0B4000;
       static constexpr size_t size = 0x34C000;
       static constexpr size_t blockSize = 4096;
+      static constexpr size_t blockCount = size / blockSize;
+      static constexpr size_t preErasedBlocks = 16;
+      static constexpr const char* eraseCountsPath = "/.system/wear.dat";
+      static constexpr uint8_t eraseCountsVersion = 1;
+      // The counts of the erases since the last save are lost on reset
+      static constexpr uint16_t eraseCountsSavePeriod = 64;
 
       bool resourcesValid = false;
       const struct lfs_config lfsConfig;
 
       lfs_t lfs;
 
+      std::array<uint8_t, FS_CACHE_SIZE> readBuffer;
+      std::array<uint8_t, FS_CACHE_SIZE> progBuffer;
+      std::array<uint32_t, FS_LOOKAHEAD_SIZE / 4> lookaheadBuffer;
+
+      // Bytes following the last sequential read, in the same block
+      std::array<uint8_t, FS_READ_AHEAD_SIZE> readAhead;
+      size_t readAheadAddress = 0;
+      size_t readAheadLength = 0;
+      size_t lastReadEnd = 0;
+
+      // Blocks in use when littlefs was last traversed, valid until littlefs erases or programs a block
+      std::bitset<blockCount> usedBlocks;
+      bool usedBlocksValid = false;
+      // Blocks erased by PreErase() and not allocated since. Lost on reset, the blocks are then erased again by littlefs.
+      std::bitset<blockCount> erasedBlocks;
+      // littlefs allocates the blocks in order: the next allocations follow the last block it erased
+      lfs_block_t allocationCursor = 0;
+
+      std::array<uint8_t, blockCount> eraseCounts {};
+      uint16_t erasesSinceSave = 0;
+      uint32_t eraseCountRandom = 0x2545F491; // xorshift32 state
+
+      SemaphoreHandle_t mutex;
+      // Set by Sleep(): the flash and the bus are only powered while the lock is held
+      bool sleeping = false;
+      bool powered = false;
+      uint8_t holds = 0;
+      bool flashPoweredDown = false;
+      Pinetime::Drivers::SpiMaster* sleepingBus = nullptr;
+      std::array<CachedFile, cachedFiles> cache;
+      uint32_t useCounter = 0;
+      Statistics statistics {};
+
       static int SectorSync(const struct lfs_config* c);
       static int SectorErase(const struct lfs_config* c, lfs_block_t block);
       static int SectorProg(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, const void* buffer, lfs_size_t size);
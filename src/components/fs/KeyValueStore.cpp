@@ -0,0 +1,81 @@
+#include "components/fs/KeyValueStore.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+using namespace Pinetime::Controllers;
+
+KeyValueStore::KeyValueStore(FS& fs) : fs {fs} {
+}
+
+int KeyValueStore::Get(Key key, void* value, size_t size) const {
+  auto* bytes = static_cast<uint8_t*>(value);
+  std::array<uint8_t, FS::maxAttributeSize> slice;
+  size_t length = 0;
+  for (size_t i = 0; i < maxSlices; i++) {
+    int res = fs.GetAttribute(path, Type(key, i), slice.data(), slice.size());
+    if (res < 0) {
+      return res;
+    }
+    size_t sliceLength = std::min<size_t>(res, slice.size());
+    if (length < size) {
+      std::memcpy(bytes + length, slice.data(), std::min(sliceLength, size - length));
+    }
+    length += sliceLength;
+    if (sliceLength < slice.size()) {
+      return length;
+    }
+  }
+  return LFS_ERR_CORRUPT;
+}
+
+// Only the slices which changed are written, in a single commit: after a reset, the store holds either the previous
+// value or the new one
+int KeyValueStore::Set(Key key, const void* value, size_t size) const {
+  if (size > maxValueSize) {
+    return LFS_ERR_FBIG;
+  }
+  auto* bytes = static_cast<const uint8_t*>(value);
+  std::array<lfs_attr, maxSlices> changed;
+  size_t count = 0;
+  std::array<uint8_t, FS::maxAttributeSize> stored;
+  for (size_t i = 0; i <= size / stored.size(); i++) {
+    size_t offset = i * stored.size();
+    size_t length = std::min(stored.size(), size - offset);
+    int res = fs.GetAttribute(path, Type(key, i), stored.data(), stored.size());
+    if (res == static_cast<int>(length) && std::memcmp(stored.data(), bytes + offset, length) == 0) {
+      continue;
+    }
+    changed[count++] = {Type(key, i), const_cast<uint8_t*>(bytes + offset), static_cast<lfs_size_t>(length)};
+  }
+  if (count == 0) {
+    return LFS_ERR_OK;
+  }
+
+  int res = fs.SetAttributes(path, changed.data(), count);
+  if (res == LFS_ERR_NOENT) {
+    fs.DirCreate("/.system");
+    res = fs.SetAttributes(path, changed.data(), count);
+  }
+  return res;
+}
+
+// littlefs commits the removal of an attribute even if it doesn't exist: the slices are looked up first.
+// The first slice is removed first, the value is gone even if the other slices are left behind by a reset.
+int KeyValueStore::Remove(Key key) const {
+  std::array<uint8_t, FS::maxAttributeSize> slice;
+  size_t count = 0;
+  while (count < maxSlices && fs.GetAttribute(path, Type(key, count), slice.data(), slice.size()) >= 0) {
+    count++;
+  }
+  if (count == 0) {
+    return LFS_ERR_NOATTR;
+  }
+  for (size_t i = 0; i < count; i++) {
+    int res = fs.RemoveAttribute(path, Type(key, i));
+    if (res != LFS_ERR_OK) {
+      return res;
+    }
+  }
+  return LFS_ERR_OK;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "components/fs/FS.h"
+
+namespace Pinetime {
+  namespace Controllers {
+    // Small values (settings, alarm, bonds) saved as custom attributes of /.system/store.
+    // littlefs keeps the attributes in the metadata log of the directory: saving a value appends one commit, protected
+    // by a CRC, with the slices of the value that changed. littlefs compacts the log when its block is full.
+    // Unlike rewriting a file, this doesn't allocate nor program data blocks, and unchanged values are not written.
+    //
+    // A value is split in slices of FS::maxAttributeSize bytes, attribute key << 4 | slice.
+    // The last slice is shorter than the others, and may be empty: it marks the end of the value.
+    class KeyValueStore {
+    public:
+      // The values are part of the format
+      enum class Key : uint8_t {
+        Settings = 1,
+        Alarm = 2,
+        Bond = 3,
+      };
+
+      static constexpr size_t maxSlices = 16;
+      static constexpr size_t maxValueSize = maxSlices * FS::maxAttributeSize - 1;
+
+      explicit KeyValueStore(FS& fs);
+
+      // Reads up to size bytes of the value, and returns the size of the value or a negative error
+      int Get(Key key, void* value, size_t size) const;
+      int Set(Key key, const void* value, size_t size) const;
+      int Remove(Key key) const;
+
+      static constexpr const char* path = "/.system/store";
+
+    private:
+      static uint8_t Type(Key key, size_t slice) {
+        return (static_cast<uint8_t>(key) << 4) | slice;
+      }
+
+      FS& fs;
+    };
+  }
+}
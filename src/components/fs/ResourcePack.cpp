@@ -0,0 +1,120 @@
+#include "components/fs/ResourcePack.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include "components/fs/FS.h"
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  struct __attribute__((packed)) Header {
+    char magic[4];
+    uint16_t version;
+    uint16_t count;
+    uint8_t reserved[8];
+  };
+
+  constexpr char magic[4] = {'R', 'P', 'A', 'K'};
+  constexpr uint16_t version = 1;
+}
+
+ResourcePack::ResourcePack(FS& filesystem) : filesystem {filesystem} {
+}
+
+uint32_t ResourcePack::Hash(const char* path) {
+  uint32_t hash = 2166136261u;
+  for (; *path != '\0'; path++) {
+    hash = (hash ^ static_cast<uint8_t>(*path)) * 16777619u;
+  }
+  return hash;
+}
+
+// Binary search in the index, which is read through the cache of littlefs
+bool ResourcePack::Find(lfs_file_t& pack, const char* path, Entry& entry) {
+  Header header;
+  if (filesystem.FileRead(&pack, reinterpret_cast<uint8_t*>(&header), sizeof(header)) != sizeof(header) ||
+      std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version) {
+    return false;
+  }
+  uint32_t hash = Hash(path);
+  uint16_t low = 0;
+  uint16_t high = header.count;
+  while (low < high) {
+    uint16_t middle = low + (high - low) / 2;
+    if (filesystem.FileSeek(&pack, sizeof(Header) + middle * sizeof(Entry)) < 0 ||
+        filesystem.FileRead(&pack, reinterpret_cast<uint8_t*>(&entry), sizeof(entry)) != sizeof(entry)) {
+      return false;
+    }
+    // The paths of the pack have different hashes: another path with the same hash isn't in the pack
+    if (entry.hash == hash) {
+      return SamePath(pack, entry.pathOffset, path);
+    }
+    if (entry.hash < hash) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return false;
+}
+
+// Compares path to the path of an entry, terminating NUL included, a few bytes at a time
+bool ResourcePack::SamePath(lfs_file_t& pack, uint32_t pathOffset, const char* path) {
+  size_t length = std::strlen(path) + 1;
+  std::array<uint8_t, 16> buffer;
+  if (filesystem.FileSeek(&pack, pathOffset) < 0) {
+    return false;
+  }
+  for (size_t compared = 0; compared < length;) {
+    size_t chunk = std::min(length - compared, buffer.size());
+    if (filesystem.FileRead(&pack, buffer.data(), chunk) != static_cast<int>(chunk) ||
+        std::memcmp(buffer.data(), path + compared, chunk) != 0) {
+      return false;
+    }
+    compared += chunk;
+  }
+  return true;
+}
+
+int ResourcePack::Open(File& file, const char* path) {
+  file = {};
+  if (filesystem.FileOpen(&file.file, packPath, LFS_O_RDONLY) == LFS_ERR_OK) {
+    Entry entry;
+    if (Find(file.file, path, entry)) {
+      file.start = entry.offset;
+      file.size = entry.size;
+      return filesystem.FileSeek(&file.file, file.start) < 0 ? LFS_ERR_CORRUPT : LFS_ERR_OK;
+    }
+    filesystem.FileClose(&file.file);
+  }
+
+  file.size = UINT32_MAX;
+  return filesystem.FileOpen(&file.file, path, LFS_O_RDONLY);
+}
+
+int ResourcePack::Close(File& file) {
+  return filesystem.FileClose(&file.file);
+}
+
+int ResourcePack::Read(File& file, uint8_t* buffer, uint32_t size) {
+  size = std::min(size, file.size - file.position);
+  int read = filesystem.FileRead(&file.file, buffer, size);
+  if (read > 0) {
+    file.position += read;
+  }
+  return read;
+}
+
+int ResourcePack::Seek(File& file, uint32_t position) {
+  file.position = std::min(position, file.size);
+  return filesystem.FileSeek(&file.file, file.start + file.position);
+}
+
+bool ResourcePack::Exists(const char* path) {
+  File file;
+  if (Open(file, path) != LFS_ERR_OK) {
+    return false;
+  }
+  Close(file);
+  return true;
+}
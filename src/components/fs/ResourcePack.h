@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <littlefs/lfs.h>
+
+namespace Pinetime {
+  namespace Controllers {
+    class FS;
+
+    // Resources (fonts, images) packed in a single file, /resources.pak, generated by generate-package.py --pack.
+    // A resource is found with a lookup in the index of the pack, then read sequentially: the pack stays open in the
+    // cache of FS, so its directory and metadata are not read again. The resources not in the pack are read from the
+    // file of the same path.
+    //
+    // Format, little endian:
+    //  - header, 16 bytes: "RPAK", version (u16), number of resources (u16), reserved
+    //  - index, 16 bytes per resource, sorted by hash: FNV-1a hash of the path (u32), offset in the pack (u32), size (u32),
+    //    offset of the path in the pack (u32)
+    //  - paths, NUL terminated: compared to the requested path when the hash matches
+    //  - data, each resource aligned on 16 bytes
+    class ResourcePack {
+    public:
+      struct File {
+        lfs_file_t file;
+        uint32_t start;    // offset of the resource in the pack, 0 when read from its own file
+        uint32_t size;     // UINT32_MAX when read from its own file
+        uint32_t position; // from the start of the resource
+      };
+
+      explicit ResourcePack(FS& filesystem);
+
+      int Open(File& file, const char* path);
+      int Close(File& file);
+      int Read(File& file, uint8_t* buffer, uint32_t size);
+      int Seek(File& file, uint32_t position);
+      bool Exists(const char* path);
+
+      static uint32_t Hash(const char* path);
+
+      static constexpr const char* packPath = "/resources.pak";
+
+    private:
+      struct Entry {
+        uint32_t hash;
+        uint32_t offset;
+        uint32_t size;
+        uint32_t pathOffset;
+      };
+      bool Find(lfs_file_t& pack, const char* path, Entry& entry);
+      bool SamePath(lfs_file_t& pack, uint32_t pathOffset, const char* path);
+
+      FS& filesystem;
+    };
+  }
+}
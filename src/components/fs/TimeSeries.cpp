@@ -0,0 +1,241 @@
+#include "components/fs/TimeSeries.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <libraries/log/nrf_log.h>
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  constexpr char magic[2] = {'T', 'S'};
+
+  uint32_t ReadLittleEndian(const uint8_t* bytes, size_t size) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < size; i++) {
+      value |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+    }
+    return value;
+  }
+
+  void WriteLittleEndian(uint8_t* bytes, uint32_t value, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      bytes[i] = value >> (8 * i);
+    }
+  }
+}
+
+TimeSeries::TimeSeries(FS& fs, const char* name, uint8_t valueSize, size_t retention)
+  : fs {fs}, valueSize {valueSize}, recordSize {sizeof(uint16_t) + valueSize}, retention {std::clamp<size_t>(retention, 1, maxSegments)} {
+  std::snprintf(directory, sizeof(directory), "/.system/ts/%s", name);
+}
+
+void TimeSeries::SegmentPath(char* path, uint32_t first) const {
+  std::snprintf(path, pathSize, "%s/%08lx", directory, static_cast<unsigned long>(first));
+}
+
+bool TimeSeries::ValidHeader(const uint8_t* header) const {
+  return std::memcmp(header, magic, sizeof(magic)) == 0 && header[2] == version && header[3] == valueSize;
+}
+
+void TimeSeries::Init() {
+  fs.DirCreate("/.system");
+  fs.DirCreate("/.system/ts");
+  fs.DirCreate(directory);
+
+  lfs_dir_t dir;
+  if (fs.DirOpen(directory, &dir) != LFS_ERR_OK) {
+    return;
+  }
+  lfs_info info;
+  while (fs.DirRead(&dir, &info) > 0) {
+    char* end;
+    uint32_t first = std::strtoul(info.name, &end, 16);
+    if (info.type != LFS_TYPE_REG || *end != '\0') {
+      continue;
+    }
+    if (nbSegments == segments.size()) {
+      NRF_LOG_WARNING("[TimeSeries] Too many segments in %s", directory);
+      break;
+    }
+    segments[nbSegments++] = first;
+  }
+  fs.DirClose(&dir);
+  std::sort(segments.begin(), segments.begin() + nbSegments);
+  while (nbSegments > retention) {
+    DropOldestSegment();
+  }
+  if (nbSegments == 0) {
+    return;
+  }
+
+  // The next samples are appended to the last segment, if it isn't full
+  char path[pathSize];
+  SegmentPath(path, segments[nbSegments - 1]);
+  lfs_file_t file;
+  if (fs.FileOpen(&file, path, LFS_O_RDONLY) != LFS_ERR_OK) {
+    return;
+  }
+  std::array<uint8_t, 240> buffer;
+  int read = fs.FileRead(&file, buffer.data(), headerSize);
+  if (read == static_cast<int>(headerSize) && ValidHeader(buffer.data())) {
+    lastTimestamp = ReadLittleEndian(&buffer[4], sizeof(uint32_t));
+    while ((read = fs.FileRead(&file, buffer.data(), buffer.size() - buffer.size() % recordSize)) > 0) {
+      for (size_t offset = 0; offset + recordSize <= static_cast<size_t>(read); offset += recordSize) {
+        lastTimestamp += ReadLittleEndian(&buffer[offset], sizeof(uint16_t));
+        segmentRecords++;
+      }
+    }
+  } else {
+    // Not appended to, a new segment is started with the next sample
+    segmentRecords = SamplesPerSegment();
+  }
+  fs.FileClose(&file);
+}
+
+int TimeSeries::OpenSegment(uint32_t first) {
+  if (nbSegments == retention) {
+    int res = DropOldestSegment();
+    if (res != LFS_ERR_OK) {
+      return res;
+    }
+  }
+  char path[pathSize];
+  SegmentPath(path, first);
+  int res = fs.FileOpen(&segment, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+  if (res != LFS_ERR_OK) {
+    return res;
+  }
+  std::array<uint8_t, headerSize> header {magic[0], magic[1], version, valueSize};
+  WriteLittleEndian(&header[4], first, sizeof(uint32_t));
+  if (fs.FileWrite(&segment, header.data(), header.size()) != static_cast<int>(header.size())) {
+    fs.FileClose(&segment);
+    fs.FileDelete(path);
+    return LFS_ERR_IO;
+  }
+  segmentOpen = true;
+  segments[nbSegments++] = first;
+  segmentRecords = 0;
+  lastTimestamp = first;
+  unsynced = true;
+  return LFS_ERR_OK;
+}
+
+int TimeSeries::CloseSegment() {
+  if (!segmentOpen) {
+    return LFS_ERR_OK;
+  }
+  segmentOpen = false;
+  unsynced = false;
+  return fs.FileClose(&segment);
+}
+
+int TimeSeries::DropOldestSegment() {
+  char path[pathSize];
+  SegmentPath(path, segments[0]);
+  int res = fs.FileDelete(path);
+  if (res != LFS_ERR_OK && res != LFS_ERR_NOENT) {
+    return res;
+  }
+  std::copy(segments.begin() + 1, segments.begin() + nbSegments, segments.begin());
+  nbSegments--;
+  return LFS_ERR_OK;
+}
+
+int TimeSeries::Append(uint32_t timestamp, uint32_t value) {
+  if (nbSegments > 0 && timestamp < lastTimestamp) {
+    return LFS_ERR_INVAL;
+  }
+  if (nbSegments == 0 || segmentRecords == SamplesPerSegment() || timestamp - lastTimestamp > UINT16_MAX) {
+    // Segments are named after their first sample, they must start at different times
+    if (nbSegments > 0 && timestamp == segments[nbSegments - 1]) {
+      return LFS_ERR_EXIST;
+    }
+    int res = CloseSegment();
+    if (res == LFS_ERR_OK) {
+      res = OpenSegment(timestamp);
+    }
+    if (res != LFS_ERR_OK) {
+      return res;
+    }
+  } else if (!segmentOpen) {
+    char path[pathSize];
+    SegmentPath(path, segments[nbSegments - 1]);
+    int res = fs.FileOpen(&segment, path, LFS_O_WRONLY | LFS_O_APPEND);
+    if (res != LFS_ERR_OK) {
+      return res;
+    }
+    segmentOpen = true;
+  }
+
+  std::array<uint8_t, sizeof(uint16_t) + sizeof(uint32_t)> record;
+  WriteLittleEndian(record.data(), timestamp - lastTimestamp, sizeof(uint16_t));
+  WriteLittleEndian(&record[sizeof(uint16_t)], value, valueSize);
+  if (fs.FileWrite(&segment, record.data(), recordSize) != static_cast<int>(recordSize)) {
+    return LFS_ERR_IO;
+  }
+  segmentRecords++;
+  lastTimestamp = timestamp;
+  unsynced = true;
+
+  if (segmentRecords == SamplesPerSegment()) {
+    return CloseSegment();
+  }
+  return LFS_ERR_OK;
+}
+
+int TimeSeries::Sync() {
+  if (!unsynced) {
+    return LFS_ERR_OK;
+  }
+  return CloseSegment();
+}
+
+int TimeSeries::Query(uint32_t from, uint32_t to, Sample* samples, size_t size) {
+  if (nbSegments == 0 || from > to) {
+    return 0;
+  }
+  // The records not synced yet can't be read
+  if (unsynced && to >= segments[nbSegments - 1]) {
+    int res = Sync();
+    if (res != LFS_ERR_OK) {
+      return res;
+    }
+  }
+
+  // The last segment starting at or before from, the first one otherwise
+  size_t index = std::upper_bound(segments.begin(), segments.begin() + nbSegments, from) - segments.begin();
+  index = index > 0 ? index - 1 : 0;
+
+  size_t count = 0;
+  char path[pathSize];
+  std::array<uint8_t, 240> buffer;
+  for (; index < nbSegments && segments[index] <= to && count < size; index++) {
+    SegmentPath(path, segments[index]);
+    lfs_file_t file;
+    if (fs.FileOpen(&file, path, LFS_O_RDONLY) != LFS_ERR_OK) {
+      continue;
+    }
+    int read = fs.FileRead(&file, buffer.data(), headerSize);
+    if (read != static_cast<int>(headerSize) || !ValidHeader(buffer.data())) {
+      fs.FileClose(&file);
+      continue;
+    }
+    uint32_t timestamp = ReadLittleEndian(&buffer[4], sizeof(uint32_t));
+    bool done = false;
+    while (!done && (read = fs.FileRead(&file, buffer.data(), buffer.size() - buffer.size() % recordSize)) > 0) {
+      for (size_t offset = 0; offset + recordSize <= static_cast<size_t>(read); offset += recordSize) {
+        timestamp += ReadLittleEndian(&buffer[offset], sizeof(uint16_t));
+        if (timestamp > to || count == size) {
+          done = true;
+          break;
+        }
+        if (timestamp >= from) {
+          samples[count++] = {timestamp, ReadLittleEndian(&buffer[offset + sizeof(uint16_t)], valueSize)};
+        }
+      }
+    }
+    fs.FileClose(&file);
+  }
+  return count;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "components/fs/FS.h"
+
+namespace Pinetime {
+  namespace Controllers {
+    // Samples (heart rate, steps...) of a series saved in /.system/ts/<name>/, in segments of one block.
+    // A segment is a file named after the timestamp of its first sample, in hexadecimal: the list of the segments is
+    // the sparse index of the series, kept in RAM. Queries only read the segments overlapping the requested range.
+    // The oldest segment is deleted when the series has more than maxSegments segments.
+    //
+    // Segment, little endian: header (magic "TS", version, value size, timestamp of the first sample), followed by
+    // fixed size records: seconds since the previous sample (u16), value (valueSize bytes).
+    //
+    // The current segment stays open: littlefs programs the records as its cache fills up, and copies the last
+    // block of a file when it is written again after a sync. The records appended since the last call to Sync() are
+    // lost on reset; a segment is synced when it is full.
+    class TimeSeries {
+    public:
+      struct Sample {
+        uint32_t timestamp; // s
+        uint32_t value;
+      };
+
+      static constexpr size_t maxSegments = 32;
+
+      // valueSize is 1, 2 or 4 bytes, retention is the number of segments kept, up to maxSegments
+      TimeSeries(FS& fs, const char* name, uint8_t valueSize, size_t retention);
+
+      // Builds the index from the segments in the FS, and reopens the last segment
+      void Init();
+      // Timestamps must not decrease
+      int Append(uint32_t timestamp, uint32_t value);
+      int Sync();
+      // Copies up to size samples with from <= timestamp <= to, and returns the number of samples copied or an error
+      int Query(uint32_t from, uint32_t to, Sample* samples, size_t size);
+
+      size_t Segments() const {
+        return nbSegments;
+      }
+
+      size_t SamplesPerSegment() const {
+        return (FS::getBlockSize() - headerSize) / recordSize;
+      }
+
+    private:
+      static constexpr size_t headerSize = 8;
+      static constexpr uint8_t version = 1;
+      static constexpr size_t directorySize = 32;
+      static constexpr size_t pathSize = directorySize + 9; // "/" and 8 hexadecimal digits
+
+      void SegmentPath(char* path, uint32_t first) const;
+      bool ValidHeader(const uint8_t* header) const;
+      int OpenSegment(uint32_t first);
+      int CloseSegment();
+      int DropOldestSegment();
+
+      FS& fs;
+      char directory[directorySize];
+      const uint8_t valueSize;
+      const size_t recordSize;
+      const size_t retention;
+
+      // Timestamp of the first sample of each segment, in chronological order
+      std::array<uint32_t, maxSegments> segments;
+      size_t nbSegments = 0;
+
+      lfs_file_t segment;
+      bool segmentOpen = false;
+      size_t segmentRecords = 0; // in the last segment
+      uint32_t lastTimestamp = 0;
+      bool unsynced = false;
+    };
+  }
+}
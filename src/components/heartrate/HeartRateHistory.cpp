@@ -0,0 +1,83 @@
+#include "components/heartrate/HeartRateHistory.h"
+#include <chrono>
+#include <nrf_log.h>
+#include "components/datetime/DateTimeController.h"
+#include "components/fs/FS.h"
+
+using namespace Pinetime::Controllers;
+
+HeartRateHistory::HeartRateHistory(FS& fs, DateTime& dateTimeController)
+  : fs {fs}, dateTimeController {dateTimeController}, series {fs, "hr", sizeof(uint8_t), flashBudget / FS::getBlockSize()} {
+  mutex = xSemaphoreCreateMutex();
+}
+
+uint32_t HeartRateHistory::Now() {
+  return std::chrono::duration_cast<std::chrono::seconds>(dateTimeController.UTCDateTime().time_since_epoch()).count();
+}
+
+// The series is opened on first use, from the heart rate task, once the file system is mounted
+void HeartRateHistory::Open() {
+  if (opened) {
+    return;
+  }
+  opened = true;
+  fs.HoldFlash();
+  series.Init();
+  fs.ReleaseFlash();
+}
+
+void HeartRateHistory::Append(uint8_t bpm) {
+  if (bpm == 0) {
+    return;
+  }
+  uint32_t timestamp = Now();
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  // Also drops samples when the clock went backwards
+  if (lastTimestamp != 0 && (timestamp < lastTimestamp || timestamp - lastTimestamp < minimumInterval)) {
+    xSemaphoreGive(mutex);
+    return;
+  }
+  lastTimestamp = timestamp;
+  pending[pendingSize++] = {timestamp, bpm};
+  if (pendingSize == pending.size()) {
+    FlushLocked();
+  }
+  xSemaphoreGive(mutex);
+}
+
+void HeartRateHistory::Flush() {
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  FlushLocked();
+  xSemaphoreGive(mutex);
+}
+
+void HeartRateHistory::FlushLocked() {
+  if (pendingSize == 0) {
+    return;
+  }
+  Open();
+  // Background measurements run while the watch sleeps: wake the flash up once for the whole flush.
+  // The segment is closed after the batch, its file cache is only allocated during the flush.
+  fs.HoldFlash();
+  for (size_t i = 0; i < pendingSize; i++) {
+    int res = series.Append(pending[i].timestamp, pending[i].value);
+    if (res != LFS_ERR_OK) {
+      NRF_LOG_WARNING("[HeartRateHistory] Failed to append: %d", res);
+    }
+  }
+  series.Sync();
+  fs.ReleaseFlash();
+  pendingSize = 0;
+}
+
+size_t HeartRateHistory::Query(uint32_t from, uint32_t to, Sample* samples, size_t maxSamples) {
+  if (from > to || maxSamples == 0) {
+    return 0;
+  }
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  FlushLocked();
+  Open();
+  int count = series.Query(from, to, samples, maxSamples);
+  xSemaphoreGive(mutex);
+  return count > 0 ? count : 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include "components/fs/TimeSeries.h"
+
+namespace Pinetime {
+  namespace Controllers {
+    class FS;
+    class DateTime;
+
+    // Long term heart rate log stored on the external flash, in the "hr" TimeSeries (3 bytes per sample).
+    // Samples are buffered in RAM and appended in batches; the oldest segments are deleted to stay within flashBudget.
+    class HeartRateHistory {
+    public:
+      // The value is the heart rate, in bpm
+      using Sample = TimeSeries::Sample;
+
+      HeartRateHistory(FS& fs, DateTime& dateTimeController);
+
+      // Records at most one value every minimumInterval seconds
+      void Append(uint8_t bpm);
+      void Flush();
+
+      // Copies the samples with from <= timestamp <= to in chronological order, and returns their number.
+      // When it equals maxSamples, more samples may follow: query again from the last timestamp + 1.
+      size_t Query(uint32_t from, uint32_t to, Sample* samples, size_t maxSamples);
+
+    private:
+      static constexpr uint32_t minimumInterval = 30;
+      static constexpr uint32_t flashBudget = 64 * 1024;
+      static constexpr size_t bufferedSamples = 8;
+
+      uint32_t Now();
+      void Open();
+      void FlushLocked();
+
+      FS& fs;
+      DateTime& dateTimeController;
+      SemaphoreHandle_t mutex;
+      TimeSeries series;
+      bool opened = false;
+
+      uint32_t lastTimestamp = 0;
+      size_t pendingSize = 0;
+      std::array<Sample, bufferedSamples> pending;
+    };
+  }
+}
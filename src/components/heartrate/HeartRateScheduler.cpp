@@ -0,0 +1,77 @@
+#include "components/heartrate/HeartRateScheduler.h"
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  int Abs(int value) {
+    return value < 0 ? -value : value;
+  }
+}
+
+void HeartRateScheduler::StartMeasurement() {
+  lastEstimate = 0;
+  consistentEstimates = 0;
+  quickResult = false;
+  motionDuringMeasurement = false;
+  measuring = true;
+}
+
+bool HeartRateScheduler::OnEstimate(int bpm, uint8_t confidence, bool motionDetected) {
+  motionDuringMeasurement |= motionDetected;
+
+  // The first estimate of a measurement is trusted if the spectrum is clean enough
+  if (consistentEstimates == 0 && lastEstimate == 0 && confidence >= highConfidence && !motionDetected) {
+    quickResult = true;
+    lastEstimate = bpm;
+    return true;
+  }
+
+  if (confidence >= minConfidence && (lastEstimate == 0 || Abs(bpm - lastEstimate) <= maxEstimateDelta)) {
+    consistentEstimates++;
+  } else {
+    consistentEstimates = 0;
+  }
+  lastEstimate = bpm;
+  return consistentEstimates >= stableEstimates;
+}
+
+void HeartRateScheduler::OnMeasurementDone(bool succeeded) {
+  // Only the first outcome of each measurement is taken into account
+  if (!measuring) {
+    return;
+  }
+  measuring = false;
+  lastMeasurementMoving = motionDuringMeasurement;
+
+  if (!succeeded) {
+    // Drive the sensor harder next time
+    if (driveLevel != DriveLevels::Maximum) {
+      driveLevel = static_cast<DriveLevels>(static_cast<uint8_t>(driveLevel) + 1);
+    }
+    return;
+  }
+
+  previousResult = lastResult;
+  lastResult = lastEstimate;
+
+  // The signal was good enough to converge straight away, so try a lower drive level next time
+  if (quickResult && driveLevel != DriveLevels::Baseline) {
+    driveLevel = static_cast<DriveLevels>(static_cast<uint8_t>(driveLevel) - 1);
+  }
+}
+
+uint32_t HeartRateScheduler::NextInterval(uint32_t baseInterval) const {
+  if (previousResult == 0 || lastResult == 0) {
+    return baseInterval;
+  }
+  int delta = Abs(lastResult - previousResult);
+  // Measure more often while the heart rate is changing
+  if (delta > variableHeartRateDelta) {
+    return baseInterval / 2;
+  }
+  // Measure less often while at rest with a steady heart rate
+  if (delta < steadyHeartRateDelta && !lastMeasurementMoving) {
+    return baseInterval * 2;
+  }
+  return baseInterval;
+}
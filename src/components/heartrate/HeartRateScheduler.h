@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Pinetime {
+  namespace Controllers {
+    // Decides when a background heart rate measurement has produced a trustworthy value,
+    // how long to wait before the next one and how hard the sensor needs to be driven.
+    class HeartRateScheduler {
+    public:
+      enum class DriveLevels : uint8_t { Baseline, Boosted, Maximum };
+
+      void StartMeasurement();
+
+      // Call for every non-zero estimate of a background measurement.
+      // Returns true once the estimate is stable enough to end the measurement.
+      bool OnEstimate(int bpm, uint8_t confidence, bool motionDetected);
+
+      // Call when a background measurement ends, successful or not
+      void OnMeasurementDone(bool succeeded);
+
+      // Scales the user selected background interval according to the recent measurements
+      uint32_t NextInterval(uint32_t baseInterval) const;
+
+      DriveLevels DriveLevel() const {
+        return driveLevel;
+      }
+
+    private:
+      // Confidence an estimate needs to count towards stability
+      static constexpr uint8_t minConfidence = 40;
+      // Confidence at which a single estimate is trusted straight away
+      static constexpr uint8_t highConfidence = 80;
+      // Number of consecutive, consistent estimates needed to end a measurement
+      static constexpr uint8_t stableEstimates = 3;
+      // Maximum difference (BPM) between consecutive estimates considered consistent
+      static constexpr int maxEstimateDelta = 4;
+      // Difference (BPM) between measurements above which the heart rate is considered variable
+      static constexpr int variableHeartRateDelta = 10;
+      // Difference (BPM) between measurements below which the heart rate is considered steady
+      static constexpr int steadyHeartRateDelta = 3;
+
+      int lastEstimate = 0;
+      uint8_t consistentEstimates = 0;
+      bool quickResult = false;
+      bool motionDuringMeasurement = false;
+      bool measuring = false;
+
+      int lastResult = 0;
+      int previousResult = 0;
+      bool lastMeasurementMoving = false;
+      DriveLevels driveLevel = DriveLevels::Baseline;
+    };
+  }
+}
@@ -142,8 +142,9 @@ Ppg::Ppg() {
   spectrum.fill(0.0f);
 }
 
-int8_t Ppg::Preprocess(uint16_t hrs, uint16_t als) {
+int8_t Ppg::Preprocess(uint16_t hrs, uint16_t als, uint16_t motion) {
   if (dataIndex < dataLength) {
+    dataMotion[dataIndex] = motion;
     dataHRS[dataIndex++] = hrs;
   }
   alsValue = als;
@@ -167,6 +168,7 @@ int Ppg::HeartRate() {
   // Make room for overlapWindow number of new samples
   for (int idx = 0; idx < dataLength - overlapWindow; idx++) {
     dataHRS[idx] = dataHRS[idx + overlapWindow];
+    dataMotion[idx] = dataMotion[idx + overlapWindow];
   }
   dataIndex = dataLength - overlapWindow;
   return hr;
@@ -184,12 +186,14 @@ void Ppg::Reset(bool resetDaqBuffer) {
   alsValue = 0;
   resetSpectralAvg = true;
   spectrum.fill(0.0f);
+  motionDetected = false;
+  confidence = 0;
 }
 
-// Pass init == true to reset spectral averaging.
-// Returns -1 (Reset Acquisition), 0 (Unable to obtain HR) or HR (BPM).
-int Ppg::ProcessHeartRate(bool init) {
-  std::copy(dataHRS.begin(), dataHRS.end(), vReal.begin());
+// Computes the magnitude spectrum of data in place in vReal.
+// Only the first spectrumLength values are meaningful.
+void Ppg::ComputeMagnitudeSpectrum(const std::array<uint16_t, dataLength>& data) {
+  std::copy(data.begin(), data.end(), vReal.begin());
   Detrend(vReal);
   Filter30to240(vReal);
   vImag.fill(0.0f);
@@ -209,6 +213,66 @@ int Ppg::ProcessHeartRate(bool init) {
   FFT.compute(FFTDirection::Forward);
   FFT.complexToMagnitude();
   FFT.~ArduinoFFT();
+}
+
+// Marks the bins around each significant peak of the motion spectrum (held in vReal)
+// and around its second harmonic, as the PPG picks up both while walking or running.
+// Returns true if any bin was marked.
+bool Ppg::DetectMotionBins() {
+  motionBins.fill(false);
+  float max = 0.0f;
+  for (int idx = 1; idx < spectrumLength; idx++) {
+    if (vReal[idx] > max) {
+      max = vReal[idx];
+    }
+  }
+  if (max < motionThreshold) {
+    return false;
+  }
+  float threshold = max * motionPeakThreshold;
+  bool detected = false;
+  for (int idx = 1; idx < spectrumLength - 1; idx++) {
+    if (vReal[idx] < threshold || vReal[idx] < vReal[idx - 1] || vReal[idx] < vReal[idx + 1]) {
+      continue;
+    }
+    const int harmonics[] = {idx, 2 * idx};
+    for (int harmonic : harmonics) {
+      for (int bin = harmonic - 1; bin <= harmonic + 1 && bin < spectrumLength; bin++) {
+        motionBins[bin] = true;
+      }
+    }
+    detected = true;
+  }
+  return detected;
+}
+
+// Maps the signal to noise ratio of the spectrum to a 0-100 confidence value
+uint8_t Ppg::ComputeConfidence(float signalToNoiseRatio) const {
+  if (signalToNoiseRatio <= signalToNoiseThreshold) {
+    return 0;
+  }
+  float ratio = (signalToNoiseRatio - signalToNoiseThreshold) / (fullConfidenceSignalToNoise - signalToNoiseThreshold);
+  if (ratio > 1.0f) {
+    ratio = 1.0f;
+  }
+  return static_cast<uint8_t>(ratio * 100.0f + 0.5f);
+}
+
+// Pass init == true to reset spectral averaging.
+// Returns -1 (Reset Acquisition), 0 (Unable to obtain HR) or HR (BPM).
+int Ppg::ProcessHeartRate(bool init) {
+  // The motion spectrum is computed first as it shares the FFT buffers with the PPG spectrum
+  ComputeMagnitudeSpectrum(dataMotion);
+  motionDetected = DetectMotionBins();
+  ComputeMagnitudeSpectrum(dataHRS);
+  // Suppress motion artifacts before they enter the spectral average
+  if (motionDetected) {
+    for (int idx = 0; idx < spectrumLength; idx++) {
+      if (motionBins[idx]) {
+        vReal[idx] *= motionSuppression;
+      }
+    }
+  }
   SpectrumAverage(vReal.data(), spectrum.data(), spectrum.size(), init);
   peakLocation = 0.0f;
   float threshold = peakDetectionThreshold;
@@ -229,6 +293,13 @@ int Ppg::ProcessHeartRate(bool init) {
                               static_cast<float>(hrROIbegin),
                               static_cast<float>(hrROIend),
                               specLen);
+    // A peak that survived suppression but still matches motion is flagged with a reduced confidence
+    auto peakBin = static_cast<int>(peakLocation + 0.5f);
+    bool onMotionBin = motionDetected && peakBin > 0 && peakBin < spectrumLength && motionBins[peakBin];
+    confidence = ComputeConfidence(signalToNoiseRatio);
+    if (onMotionBin) {
+      confidence /= 2;
+    }
     peakLocation *= freqResolution;
   }
   // Peak too wide? (broad spectrum noise or large, rapid HR change)
@@ -242,6 +313,7 @@ int Ppg::ProcessHeartRate(bool init) {
   // Reset spectral averaging if bad reading
   if (peakLocation == 0.0f) {
     resetSpectralAvg = true;
+    confidence = 0;
   }
   // Set the ambient light threshold and return HR in BPM
   alsThreshold = static_cast<uint16_t>(alsValue * alsFactor);
@@ -14,9 +14,21 @@ namespace Pinetime {
     class Ppg {
     public:
       Ppg();
-      int8_t Preprocess(uint16_t hrs, uint16_t als);
+      // motion: accelerometer magnitude sampled at the same time as hrs (binary milli-g)
+      int8_t Preprocess(uint16_t hrs, uint16_t als, uint16_t motion);
       int HeartRate();
       void Reset(bool resetDaqBuffer);
+
+      // Confidence (0-100) of the last spectral analysis
+      uint8_t Confidence() const {
+        return confidence;
+      }
+
+      // True if the last spectral analysis detected significant periodic motion
+      bool MotionDetected() const {
+        return motionDetected;
+      }
+
       static constexpr int deltaTms = 100;
       // Daq dataLength: Must be power of 2
       static constexpr uint16_t dataLength = 64;
@@ -51,15 +63,27 @@ namespace Pinetime {
       static constexpr float dcThreshold = 0.5f;
       // ALS detection factor
       static constexpr float alsFactor = 2.0f;
+      // Minimum motion spectrum magnitude for a motion peak (~10 milli-g sinusoid)
+      static constexpr float motionThreshold = 200.0f;
+      // Motion peaks above this threshold (% of motion max) are treated as artifacts
+      static constexpr float motionPeakThreshold = 0.5f;
+      // Attenuation applied to the PPG spectrum at motion artifact bins
+      static constexpr float motionSuppression = 0.1f;
+      // Signal to noise ratio at which the confidence reaches 100%
+      static constexpr float fullConfidenceSignalToNoise = 3.0f * signalToNoiseThreshold;
 
       // Raw ADC data
       std::array<uint16_t, dataLength> dataHRS;
+      // Accelerometer magnitude, synchronized with dataHRS
+      std::array<uint16_t, dataLength> dataMotion;
       // Stores Real numbers from FFT
       std::array<float, dataLength> vReal;
       // Stores Imaginary numbers from FFT
       std::array<float, dataLength> vImag;
       // Stores power spectrum calculated from FFT real and imag values
       std::array<float, (spectrumLength)> spectrum;
+      // Bins of the PPG spectrum that match motion peaks or their harmonics
+      std::array<bool, spectrumLength> motionBins;
       // Stores each new HR value (Hz). Non zero values are averaged for HR output
       std::array<float, 20> dataAverage;
 
@@ -72,8 +96,13 @@ namespace Pinetime {
       float peakLocation;
       bool resetSpectralAvg = true;
       bool enoughData = false;
+      bool motionDetected = false;
+      uint8_t confidence = 0;
 
       int ProcessHeartRate(bool init);
+      void ComputeMagnitudeSpectrum(const std::array<uint16_t, dataLength>& data);
+      bool DetectMotionBins();
+      uint8_t ComputeConfidence(float signalToNoiseRatio) const;
       float HeartRateAverage(float hr);
       void SpectrumAverage(const float* data, float* spectrum, int length, bool reset);
     };
@@ -0,0 +1,88 @@
+#include "components/heartrate/PpgCapture.h"
+#include <nrf_log.h>
+#include "components/fs/FS.h"
+
+using namespace Pinetime::Controllers;
+
+PpgCapture::PpgCapture(FS& fs) : fs {fs} {
+}
+
+void PpgCapture::CheckArmed() {
+  if (capturing) {
+    return;
+  }
+  // Only capture if the file was created beforehand
+  lfs_info info;
+  armed = fs.Stat(captureFile, &info) == LFS_ERR_OK && info.size < maxFileSize;
+  fileSize = armed ? info.size : 0;
+}
+
+void PpgCapture::Start(uint32_t timestamp, uint8_t deltaTms) {
+  if (capturing) {
+    Stop();
+  }
+  if (!armed) {
+    return;
+  }
+
+  if (fs.FileOpen(&file, captureFile, LFS_O_WRONLY | LFS_O_APPEND) != LFS_ERR_OK) {
+    NRF_LOG_WARNING("[PpgCapture] Failed to open capture file");
+    armed = false;
+    return;
+  }
+
+  PpgCaptureFormat::SessionHeader header;
+  header.deltaTms = deltaTms;
+  header.timestamp = timestamp;
+  if (fs.FileWrite(&file, reinterpret_cast<const uint8_t*>(&header), sizeof(header)) != sizeof(header)) {
+    fs.FileClose(&file);
+    armed = false;
+    return;
+  }
+  fileSize += sizeof(header);
+  lastTimestamp = timestamp;
+  sampleCount = 0;
+  capturing = true;
+}
+
+void PpgCapture::AddSample(uint32_t timestamp, uint16_t hrs, uint16_t als, int16_t x, int16_t y, int16_t z) {
+  if (!capturing) {
+    return;
+  }
+  uint32_t delta = timestamp - lastTimestamp;
+  if (delta >= PpgCaptureFormat::sessionMarker) {
+    delta = PpgCaptureFormat::sessionMarker - 1;
+  }
+  lastTimestamp = timestamp;
+  samples[sampleCount++] = {static_cast<uint16_t>(delta), hrs, als, x, y, z};
+  if (sampleCount == samples.size()) {
+    Flush();
+  }
+}
+
+void PpgCapture::Stop() {
+  if (!capturing) {
+    return;
+  }
+  Flush();
+  if (capturing) {
+    fs.FileClose(&file);
+    capturing = false;
+  }
+}
+
+void PpgCapture::Flush() {
+  uint32_t size = sampleCount * sizeof(PpgCaptureFormat::Sample);
+  sampleCount = 0;
+  if (size == 0) {
+    return;
+  }
+  if (fileSize + size > maxFileSize ||
+      fs.FileWrite(&file, reinterpret_cast<const uint8_t*>(samples.data()), size) != static_cast<int>(size)) {
+    fs.FileClose(&file);
+    capturing = false;
+    armed = false;
+    return;
+  }
+  fileSize += size;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <littlefs/lfs.h>
+#include "components/heartrate/PpgCaptureFormat.h"
+
+namespace Pinetime {
+  namespace Controllers {
+    class FS;
+
+    // Records the raw HRS/ALS samples and the accelerometer data fed to Ppg, for offline tuning.
+    // Capturing is armed by creating an empty file at captureFile (for example over BLE FS)
+    // and stops once the file reaches maxFileSize. The file is looked for by CheckArmed(), when the task starts and
+    // when the watch wakes up, not at each measurement.
+    class PpgCapture {
+    public:
+      static constexpr const char* captureFile = "/.system/ppg.cap";
+
+      explicit PpgCapture(FS& fs);
+
+      void CheckArmed();
+      void Start(uint32_t timestamp, uint8_t deltaTms);
+      void AddSample(uint32_t timestamp, uint16_t hrs, uint16_t als, int16_t x, int16_t y, int16_t z);
+      void Stop();
+
+      bool IsCapturing() const {
+        return capturing;
+      }
+
+    private:
+      static constexpr uint32_t maxFileSize = 128 * 1024;
+      // Samples are written in batches to limit the number of file system operations
+      static constexpr uint8_t bufferedSamples = 16;
+
+      void Flush();
+
+      FS& fs;
+      lfs_file_t file;
+      bool armed = false;
+      bool capturing = false;
+      uint32_t fileSize = 0;
+      uint32_t lastTimestamp = 0;
+      uint8_t sampleCount = 0;
+      std::array<PpgCaptureFormat::Sample, bufferedSamples> samples;
+    };
+  }
+}
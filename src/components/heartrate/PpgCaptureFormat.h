@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary layout of the raw PPG capture file, shared with tools/ppg-replay.
+// All values are little endian. A capture is a sequence of sessions, each one
+// made of a SessionHeader followed by Samples.
+namespace Pinetime {
+  namespace Controllers {
+    namespace PpgCaptureFormat {
+      static constexpr uint8_t version = 1;
+      static constexpr uint16_t sessionMarker = 0xffff;
+
+      struct __attribute__((packed)) SessionHeader {
+        uint16_t marker = sessionMarker;
+        uint8_t version = PpgCaptureFormat::version;
+        uint8_t deltaTms = 0;   // Nominal sampling period
+        uint32_t timestamp = 0; // Milliseconds since boot
+      };
+
+      struct __attribute__((packed)) Sample {
+        uint16_t delta; // Milliseconds since the previous sample (or the session start), never sessionMarker
+        uint16_t hrs;
+        uint16_t als;
+        int16_t x; // Accelerometer, binary milli-g
+        int16_t y;
+        int16_t z;
+      };
+
+      static_assert(sizeof(SessionHeader) == 8);
+      static_assert(sizeof(Sample) == 12);
+    }
+  }
+}
@@ -0,0 +1,28 @@
+#include "components/motion/Actigraphy.h"
+#include <algorithm>
+
+using namespace Pinetime::Controllers;
+
+bool Actigraphy::Push(uint16_t counts, Epoch& scored) {
+  std::rotate(window.begin(), window.begin() + 1, window.end());
+  window.back() = counts;
+  if (filled < window.size()) {
+    filled++;
+  }
+  // The epoch at index current needs the 2 following ones; missing previous epochs count as 0
+  if (filled < window.size() - current) {
+    return false;
+  }
+
+  uint32_t sum = 0;
+  for (size_t i = 0; i < window.size(); i++) {
+    sum += static_cast<uint32_t>(weights[i]) * window[i];
+  }
+  scored = {window[current], sum >= wakeThreshold};
+  return true;
+}
+
+void Actigraphy::Reset() {
+  window.fill(0);
+  filled = 0;
+}
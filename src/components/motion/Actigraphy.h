@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace Pinetime {
+  namespace Controllers {
+    // Sleep/wake scoring of 30s actigraphy epochs, with the Cole-Kripke algorithm for 30s epochs:
+    // an epoch is scored awake when the weighted sum of its counts and of its neighbours
+    // (4 epochs before, 2 after) reaches wakeThreshold.
+    class Actigraphy {
+    public:
+      struct Epoch {
+        uint16_t counts;
+        bool awake;
+      };
+
+      // Adds the counts of the epoch that just ended.
+      // Scoring an epoch needs the 2 following ones: returns true when the epoch 2 epochs ago was scored.
+      bool Push(uint16_t counts, Epoch& scored);
+
+      // Restarts the scoring, when epochs are missing
+      void Reset();
+
+      static constexpr uint32_t epochDuration = 30; // seconds
+      // Divides MotionController::ConsumeActigraphyCounts() to get the counts of an epoch,
+      // roughly calibrated on the range of the counts of the original algorithm
+      static constexpr uint32_t countsDivisor = 256;
+
+    private:
+      static constexpr std::array<uint16_t, 7> weights {50, 30, 14, 28, 121, 8, 50};
+      // The original scale factor is 0.0001: awake when the weighted sum is at least 1
+      static constexpr uint32_t wakeThreshold = 10000;
+      static constexpr uint8_t current = 4;
+
+      // Oldest first, the epoch being scored is at index current. Missing epochs are 0.
+      std::array<uint16_t, weights.size()> window {};
+      uint8_t filled = 0;
+    };
+  }
+}
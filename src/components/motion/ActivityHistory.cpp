@@ -0,0 +1,264 @@
+#include "components/motion/ActivityHistory.h"
+#include <algorithm>
+#include <chrono>
+#include <nrf_log.h>
+#include "components/datetime/DateTimeController.h"
+#include "components/fs/FS.h"
+#include "components/motion/MotionController.h"
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  constexpr uint32_t secondsPerMinute = 60;
+  constexpr uint32_t minutesPerHour = 60;
+  constexpr uint32_t hoursPerDay = 24;
+
+  // Reads the records of indexes first to last from a file of capacity records, where index i is stored at slot i % capacity.
+  // Callback receives each index and its record, and returns false to stop.
+  template <typename Record, typename Callback>
+  void ReadRecords(FS& fs, const char* path, uint32_t capacity, uint32_t first, uint32_t last, Callback callback) {
+    lfs_file_t file;
+    if (fs.FileOpen(&file, path, LFS_O_RDONLY) != LFS_ERR_OK) {
+      return;
+    }
+    std::array<Record, 8> buffer;
+    uint32_t index = first;
+    while (index <= last) {
+      uint32_t slot = index % capacity;
+      uint32_t count = std::min({static_cast<uint32_t>(buffer.size()), last - index + 1, capacity - slot});
+      fs.FileSeek(&file, slot * sizeof(Record));
+      int size = fs.FileRead(&file, reinterpret_cast<uint8_t*>(buffer.data()), count * sizeof(Record));
+      if (size <= 0) {
+        break;
+      }
+      count = size / sizeof(Record);
+      for (uint32_t i = 0; i < count; i++) {
+        if (!callback(index + i, buffer[i])) {
+          fs.FileClose(&file);
+          return;
+        }
+      }
+      index += count;
+    }
+    fs.FileClose(&file);
+  }
+
+  template <typename Record>
+  void WriteRecord(FS& fs, const char* path, uint32_t slot, const Record& record) {
+    lfs_file_t file;
+    if (fs.FileOpen(&file, path, LFS_O_WRONLY | LFS_O_CREAT) != LFS_ERR_OK) {
+      NRF_LOG_WARNING("[ActivityHistory] Failed to open %s", path);
+      return;
+    }
+    // Seeking past the end of the file fills the gap with zeros, which are invalid records
+    fs.FileSeek(&file, slot * sizeof(Record));
+    if (fs.FileWrite(&file, reinterpret_cast<const uint8_t*>(&record), sizeof(Record)) != sizeof(Record)) {
+      NRF_LOG_WARNING("[ActivityHistory] Failed to write %s", path);
+    }
+    fs.FileClose(&file);
+  }
+}
+
+ActivityHistory::ActivityHistory(FS& fs, DateTime& dateTimeController, MotionController& motionController, uint8_t weeks)
+  : fs {fs}, dateTimeController {dateTimeController}, motionController {motionController}, daysCapacity {weeks * 7U} {
+  mutex = xSemaphoreCreateMutex();
+}
+
+uint32_t ActivityHistory::Now() {
+  return std::chrono::duration_cast<std::chrono::seconds>(dateTimeController.UTCDateTime().time_since_epoch()).count();
+}
+
+uint32_t ActivityHistory::SecondsToNextMinute() {
+  return secondsPerMinute - Now() % secondsPerMinute;
+}
+
+void ActivityHistory::Init() {
+  lastSteps = motionController.NbSteps();
+  motionController.ConsumeActivity();
+  minuteStart = Now() / secondsPerMinute;
+}
+
+void ActivityHistory::OnMinute() {
+  // The step counter is reset every day
+  uint32_t steps = motionController.NbSteps();
+  uint32_t deltaSteps = steps >= lastSteps ? steps - lastSteps : steps;
+  lastSteps = steps;
+  uint16_t intensity = motionController.ConsumeActivity() / 4;
+
+  // The data belongs to the minute that just ended, even when the message was handled late
+  uint32_t minute = minuteStart;
+  minuteStart = Now() / secondsPerMinute;
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  Record(minute, {static_cast<uint8_t>(std::min<uint32_t>(deltaSteps, UINT8_MAX)), static_cast<uint8_t>(std::min<uint16_t>(intensity, UINT8_MAX))});
+  xSemaphoreGive(mutex);
+}
+
+void ActivityHistory::Record(uint32_t minute, Minute value) {
+  if (lastMinute == 0 || minute < lastMinute || minute - lastMinute >= ringSize) {
+    // First record, or the clock was changed: restart the ring
+    if (lastMinute != 0) {
+      FlushHour(lastMinute / minutesPerHour);
+    }
+    minutes.fill({});
+    lastMinute = minute;
+  }
+  while (lastMinute < minute) {
+    lastMinute++;
+    if (lastMinute % minutesPerHour == 0) {
+      FlushHour(lastMinute / minutesPerHour - 1);
+    }
+    minutes[lastMinute % ringSize] = {};
+  }
+
+  auto& entry = minutes[minute % ringSize];
+  entry.steps = std::min<uint32_t>(entry.steps + value.steps, UINT8_MAX);
+  entry.intensity = std::max(entry.intensity, value.intensity);
+}
+
+ActivityHistory::HourRecord ActivityHistory::HourTotals(uint32_t hour) const {
+  HourRecord record {hour, 0, 0, 0};
+  uint32_t first = std::max(hour * minutesPerHour, lastMinute >= ringSize ? lastMinute - ringSize + 1 : 0);
+  uint32_t last = std::min(hour * minutesPerHour + minutesPerHour - 1, lastMinute);
+  uint32_t intensitySum = 0;
+  for (uint32_t minute = first; minute <= last && lastMinute != 0; minute++) {
+    const auto& entry = minutes[minute % ringSize];
+    record.steps += entry.steps;
+    intensitySum += entry.intensity;
+    if (entry.steps > 0 || entry.intensity >= activeIntensity) {
+      record.activeMinutes++;
+    }
+  }
+  record.intensity = intensitySum / minutesPerHour;
+  return record;
+}
+
+void ActivityHistory::FlushHour(uint32_t hour) {
+  // Called every hour whatever the state of the watch: wake the flash up once for the whole flush
+  fs.HoldFlash();
+  if (!directoryChecked) {
+    lfs_dir_t dir;
+    if (fs.DirOpen("/.system", &dir) != LFS_ERR_OK) {
+      fs.DirCreate("/.system");
+    } else {
+      fs.DirClose(&dir);
+    }
+    if (fs.DirOpen(directory, &dir) != LFS_ERR_OK) {
+      fs.DirCreate(directory);
+    } else {
+      fs.DirClose(&dir);
+    }
+    directoryChecked = true;
+  }
+
+  auto hourRecord = HourTotals(hour);
+  uint32_t day = hour / hoursPerDay;
+  DayRecord dayRecord {day, 0, 0, 0, 0};
+  ReadRecords<DayRecord>(fs, daysFile, daysCapacity, day, day, [&](uint32_t, const DayRecord& record) {
+    if (record.day == day) {
+      dayRecord = record;
+    }
+    return false;
+  });
+
+  // An hour can be flushed twice when the clock changes: replace its previous totals in the day
+  uint32_t intensitySum = dayRecord.intensity * dayRecord.hours;
+  ReadRecords<HourRecord>(fs, hoursFile, hoursCapacity, hour, hour, [&](uint32_t, const HourRecord& record) {
+    if (record.hour == hour && dayRecord.hours > 0) {
+      dayRecord.steps -= std::min<uint32_t>(record.steps, dayRecord.steps);
+      dayRecord.activeMinutes -= std::min<uint16_t>(record.activeMinutes, dayRecord.activeMinutes);
+      intensitySum -= std::min<uint32_t>(record.intensity, intensitySum);
+      dayRecord.hours--;
+    }
+    return false;
+  });
+
+  dayRecord.steps += hourRecord.steps;
+  dayRecord.activeMinutes += hourRecord.activeMinutes;
+  dayRecord.hours++;
+  dayRecord.intensity = (intensitySum + hourRecord.intensity) / dayRecord.hours;
+
+  WriteRecord(fs, hoursFile, hour % hoursCapacity, hourRecord);
+  WriteRecord(fs, daysFile, day % daysCapacity, dayRecord);
+  fs.ReleaseFlash();
+}
+
+ActivityHistory::Totals ActivityHistory::ToTotals(const HourRecord& record) {
+  return {record.hour * minutesPerHour * secondsPerMinute, record.steps, record.activeMinutes, record.intensity};
+}
+
+ActivityHistory::Totals ActivityHistory::ToTotals(const DayRecord& record) {
+  return {record.day * hoursPerDay * minutesPerHour * secondsPerMinute, record.steps, record.activeMinutes, record.intensity};
+}
+
+size_t ActivityHistory::QueryMinutes(uint32_t from, uint32_t to, MinuteSample* samples, size_t maxSamples) {
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  size_t count = 0;
+  if (lastMinute != 0 && from <= to) {
+    uint32_t first = std::max(from / secondsPerMinute, lastMinute >= ringSize ? lastMinute - ringSize + 1 : 0);
+    uint32_t last = std::min(to / secondsPerMinute, lastMinute);
+    for (uint32_t minute = first; minute <= last && count < maxSamples; minute++) {
+      const auto& entry = minutes[minute % ringSize];
+      samples[count++] = {minute * secondsPerMinute, entry.steps, entry.intensity};
+    }
+  }
+  xSemaphoreGive(mutex);
+  return count;
+}
+
+size_t ActivityHistory::QueryHours(uint32_t from, uint32_t to, Totals* totals, size_t maxTotals) {
+  constexpr uint32_t secondsPerHour = minutesPerHour * secondsPerMinute;
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  size_t count = 0;
+  uint32_t currentHour = lastMinute / minutesPerHour;
+  if (lastMinute != 0 && from <= to && maxTotals > 0) {
+    // Only the last hoursCapacity hours are stored, the current one is still in the ring
+    uint32_t first = std::max(from / secondsPerHour, currentHour >= hoursCapacity ? currentHour - hoursCapacity : 0);
+    uint32_t last = std::min(to / secondsPerHour, currentHour);
+    if (first < currentHour) {
+      ReadRecords<HourRecord>(fs, hoursFile, hoursCapacity, first, std::min(last, currentHour - 1), [&](uint32_t hour, const HourRecord& record) {
+        if (record.hour == hour) {
+          totals[count++] = ToTotals(record);
+        }
+        return count < maxTotals;
+      });
+    }
+    if (last == currentHour && count < maxTotals) {
+      totals[count++] = ToTotals(HourTotals(currentHour));
+    }
+  }
+  xSemaphoreGive(mutex);
+  return count;
+}
+
+size_t ActivityHistory::QueryDays(uint32_t from, uint32_t to, Totals* totals, size_t maxTotals) {
+  constexpr uint32_t secondsPerDay = hoursPerDay * minutesPerHour * secondsPerMinute;
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  size_t count = 0;
+  uint32_t currentHour = lastMinute / minutesPerHour;
+  uint32_t currentDay = currentHour / hoursPerDay;
+  if (lastMinute != 0 && from <= to && maxTotals > 0) {
+    uint32_t first = std::max(from / secondsPerDay, currentDay >= daysCapacity ? currentDay - daysCapacity + 1 : 0);
+    uint32_t last = std::min(to / secondsPerDay, currentDay);
+    bool currentDayFound = false;
+    ReadRecords<DayRecord>(fs, daysFile, daysCapacity, first, last, [&](uint32_t day, const DayRecord& record) {
+      if (record.day == day) {
+        totals[count++] = ToTotals(record);
+        currentDayFound = day == currentDay;
+      }
+      return count < maxTotals;
+    });
+
+    // The current hour is not flushed yet
+    if (last == currentDay && (currentDayFound || count < maxTotals)) {
+      auto hour = HourTotals(currentHour);
+      if (!currentDayFound) {
+        totals[count++] = {currentDay * secondsPerDay, 0, 0, 0};
+      }
+      auto& today = totals[count - 1];
+      today.steps += hour.steps;
+      today.activeMinutes += hour.activeMinutes;
+    }
+  }
+  xSemaphoreGive(mutex);
+  return count;
+}
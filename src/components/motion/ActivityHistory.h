@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <FreeRTOS.h>
+#include <semphr.h>
+
+namespace Pinetime {
+  namespace Controllers {
+    class FS;
+    class DateTime;
+    class MotionController;
+
+    // Step and activity history.
+    // Minutes are kept in a RAM ring, and rolled up into hourly and daily totals stored in littlefs files.
+    // Both files are rings of fixed size records indexed by hour (or day), so that a time range
+    // can be read with a few seeks, without scanning the whole history.
+    class ActivityHistory {
+    public:
+      struct MinuteSample {
+        uint32_t timestamp; // UTC, seconds since epoch, start of the minute
+        uint8_t steps;
+        uint8_t intensity;
+      };
+
+      struct Totals {
+        uint32_t timestamp; // UTC, seconds since epoch, start of the hour or day
+        uint32_t steps;
+        uint16_t activeMinutes;
+        uint8_t intensity; // average over the minutes
+      };
+
+      ActivityHistory(FS& fs, DateTime& dateTimeController, MotionController& motionController, uint8_t weeks);
+
+      // Starts the current minute, so that the steps counted before are not credited to it
+      void Init();
+
+      // Records the steps and the activity since the previous call in the minute it started in.
+      // Should be called right after each minute boundary.
+      void OnMinute();
+
+      // Time until the next minute boundary of the clock, when OnMinute should be called
+      uint32_t SecondsToNextMinute();
+
+      // Copy the records with from <= timestamp <= to in chronological order, and return their number.
+      // Minutes are only available for the last ringSize minutes.
+      size_t QueryMinutes(uint32_t from, uint32_t to, MinuteSample* samples, size_t maxSamples);
+      size_t QueryHours(uint32_t from, uint32_t to, Totals* totals, size_t maxTotals);
+      size_t QueryDays(uint32_t from, uint32_t to, Totals* totals, size_t maxTotals);
+
+    private:
+      struct Minute {
+        uint8_t steps;
+        uint8_t intensity;
+      };
+
+      struct __attribute__((packed)) HourRecord {
+        uint32_t hour; // hours since epoch
+        uint16_t steps;
+        uint8_t activeMinutes;
+        uint8_t intensity;
+      };
+
+      struct __attribute__((packed)) DayRecord {
+        uint32_t day; // days since epoch
+        uint32_t steps;
+        uint16_t activeMinutes;
+        uint8_t intensity;
+        uint8_t hours; // number of hours averaged in intensity
+      };
+
+      static constexpr const char* directory = "/.system/activity";
+      static constexpr const char* hoursFile = "/.system/activity/hours.dat";
+      static constexpr const char* daysFile = "/.system/activity/days.dat";
+      static constexpr uint32_t hoursCapacity = 7 * 24;
+      static constexpr uint32_t ringSize = 120;
+      // A minute with at least this intensity is active even without steps
+      static constexpr uint8_t activeIntensity = 16;
+
+      uint32_t Now();
+      void Record(uint32_t minute, Minute value);
+      HourRecord HourTotals(uint32_t hour) const;
+      void FlushHour(uint32_t hour);
+      static Totals ToTotals(const HourRecord& record);
+      static Totals ToTotals(const DayRecord& record);
+
+      FS& fs;
+      DateTime& dateTimeController;
+      MotionController& motionController;
+      const uint32_t daysCapacity;
+      SemaphoreHandle_t mutex;
+
+      std::array<Minute, ringSize> minutes {};
+      uint32_t lastMinute = 0; // minutes since epoch of the newest entry of the ring, 0 if empty
+      uint32_t lastSteps = 0;
+      uint32_t minuteStart = 0; // minutes since epoch of the minute being counted
+      bool directoryChecked = false;
+    };
+  }
+}
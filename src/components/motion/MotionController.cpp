@@ -1,6 +1,6 @@
 #include "components/motion/MotionController.h"
 
-#include <task.h>
+#include <algorithm>
 
 #include "utility/Math.h"
 
@@ -35,17 +35,27 @@ namespace {
   }
 }
 
-void MotionController::Update(int16_t x, int16_t y, int16_t z, uint32_t nbSteps) {
-  if (this->nbSteps != nbSteps && service != nullptr) {
-    service->OnNewStepCountValue(nbSteps);
-  }
+void MotionController::Update(int16_t x, int16_t y, int16_t z, uint32_t nbSteps, TickType_t timestamp) {
+  UpdateSteps(nbSteps);
 
   if (service != nullptr && (xHistory[0] != x || yHistory[0] != y || zHistory[0] != z)) {
-    service->OnNewMotionValues(x, y, z);
+    service->OnNewMotionValues(x, y, z, timestamp);
   }
 
   lastTime = time;
-  time = xTaskGetTickCount();
+  time = timestamp;
+
+  if (activitySamples < UINT16_MAX) {
+    activitySum += std::abs(x - xHistory[0]) + std::abs(y - yHistory[0]) + std::abs(z - zHistory[0]);
+    activitySamples++;
+  }
+
+  // |a| - 1g is approximated by (|a|^2 - 1g^2) / 2g, which avoids a square root
+  int32_t magnitudeSquared = x * x + y * y + z * z;
+  int32_t deviation = std::abs(magnitudeSquared - 1024 * 1024) >> 11;
+  if (deviation > actigraphyDeadband) {
+    actigraphyCounts += std::min<int32_t>(deviation - actigraphyDeadband, 2048);
+  }
 
   xHistory++;
   xHistory[0] = x;
@@ -55,14 +65,20 @@ void MotionController::Update(int16_t x, int16_t y, int16_t z, uint32_t nbSteps)
   zHistory[0] = z;
 
   // Update accumulated speed
-  // Currently polling at 10Hz, if this ever goes faster scalar and EMA might need adjusting
+  // Samples come at 10Hz (polling) or 12.5Hz (FIFO), if this ever goes faster scalar and EMA might need adjusting
   int32_t speed = std::abs(zHistory[0] - zHistory[histSize - 1] + ((yHistory[0] - yHistory[histSize - 1]) / 2) +
                            ((xHistory[0] - xHistory[histSize - 1]) / 4)) *
-                  100 / (time - lastTime);
+                  100 / std::max<TickType_t>(time - lastTime, 1);
   // integer version of (.2 * speed) + ((1 - .2) * accumulatedSpeed);
   accumulatedSpeed = speed / 5 + accumulatedSpeed * 4 / 5;
 
   stats = GetAccelStats();
+}
+
+void MotionController::UpdateSteps(uint32_t nbSteps) {
+  if (this->nbSteps != nbSteps && service != nullptr) {
+    service->OnNewStepCountValue(nbSteps);
+  }
 
   int32_t deltaSteps = nbSteps - this->nbSteps;
   if (deltaSteps > 0) {
@@ -71,6 +87,19 @@ void MotionController::Update(int16_t x, int16_t y, int16_t z, uint32_t nbSteps)
   this->nbSteps = nbSteps;
 }
 
+uint16_t MotionController::ConsumeActivity() {
+  uint16_t activity = activitySamples > 0 ? activitySum / activitySamples : 0;
+  activitySum = 0;
+  activitySamples = 0;
+  return activity;
+}
+
+uint32_t MotionController::ConsumeActigraphyCounts() {
+  uint32_t counts = actigraphyCounts;
+  actigraphyCounts = 0;
+  return counts;
+}
+
 MotionController::AccelStats MotionController::GetAccelStats() const {
   AccelStats stats;
 
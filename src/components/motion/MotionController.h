@@ -18,7 +18,8 @@ namespace Pinetime {
         BMA425,
       };
 
-      void Update(int16_t x, int16_t y, int16_t z, uint32_t nbSteps);
+      void Update(int16_t x, int16_t y, int16_t z, uint32_t nbSteps, TickType_t timestamp);
+      void UpdateSteps(uint32_t nbSteps);
 
       int16_t X() const {
         return xHistory[0];
@@ -44,6 +45,12 @@ namespace Pinetime {
         return currentTripSteps;
       }
 
+      // Average change of acceleration between consecutive samples since the previous call, a measure of activity
+      uint16_t ConsumeActivity();
+
+      // Actigraphy counts since the previous call: the deviation of the acceleration magnitude from 1g, integrated over the samples
+      uint32_t ConsumeActigraphyCounts();
+
       bool ShouldRaiseWake() const;
       bool ShouldLowerSleep() const;
 
@@ -96,6 +103,11 @@ namespace Pinetime {
       Utility::CircularBuffer<int16_t, histSize> yHistory = {};
       Utility::CircularBuffer<int16_t, histSize> zHistory = {};
       int32_t accumulatedSpeed = 0;
+      uint32_t activitySum = 0;
+      uint16_t activitySamples = 0;
+      uint32_t actigraphyCounts = 0;
+      // Deviations below this (about 30mg) are sensor noise
+      static constexpr int32_t actigraphyDeadband = 32;
 
       DeviceTypes deviceType = DeviceTypes::Unknown;
       Pinetime::Controllers::MotionService* service = nullptr;
@@ -0,0 +1,191 @@
+#include "components/motion/SleepTracker.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <nrf_log.h>
+#include "components/datetime/DateTimeController.h"
+#include "components/fs/FS.h"
+#include "components/motion/MotionController.h"
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  constexpr uint32_t secondsPerDay = 24 * 60 * 60;
+  constexpr uint8_t awakeFlag = 0x80;
+}
+
+SleepTracker::SleepTracker(FS& fs, DateTime& dateTimeController, MotionController& motionController)
+  : fs {fs}, dateTimeController {dateTimeController}, motionController {motionController} {
+  mutex = xSemaphoreCreateMutex();
+}
+
+void SleepTracker::DayFilePath(uint32_t day, char* path, size_t size) {
+  snprintf(path, size, "%s/%lu", directory, static_cast<unsigned long>(day));
+}
+
+// Counts below 16 are exact, above they keep 3 bits of mantissa
+uint8_t SleepTracker::Encode(const Actigraphy::Epoch& epoch) {
+  uint8_t code = epoch.counts;
+  if (epoch.counts >= 16) {
+    uint8_t exponent = 31 - __builtin_clz(epoch.counts);
+    code = 16 + (exponent - 4) * 8 + ((epoch.counts >> (exponent - 3)) & 7);
+  }
+  return (code + 1) | (epoch.awake ? awakeFlag : 0);
+}
+
+SleepTracker::Sample SleepTracker::Decode(uint32_t epoch, uint8_t value) {
+  uint8_t code = (value & ~awakeFlag) - 1;
+  uint16_t counts = code;
+  if (code >= 16) {
+    uint8_t exponent = (code - 16) / 8 + 4;
+    uint8_t mantissa = (code - 16) % 8;
+    // Middle of the interval
+    counts = ((8 + mantissa) << (exponent - 3)) + (1 << (exponent - 4));
+  }
+  return {epoch * Actigraphy::epochDuration, counts, (value & awakeFlag) != 0};
+}
+
+uint32_t SleepTracker::Now() {
+  return std::chrono::duration_cast<std::chrono::seconds>(dateTimeController.UTCDateTime().time_since_epoch()).count();
+}
+
+void SleepTracker::OnEpoch() {
+  uint16_t counts = std::min<uint32_t>(motionController.ConsumeActigraphyCounts() / Actigraphy::countsDivisor, UINT16_MAX);
+  // The counts belong to the epoch that just ended
+  uint32_t epoch = Now() / Actigraphy::epochDuration - 1;
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  // The timer and the clock may drift by a second: only a larger jump is a gap
+  if (lastEpoch != 0 && epoch >= lastEpoch && epoch <= lastEpoch + 2) {
+    epoch = lastEpoch + 1;
+  } else if (lastEpoch != 0) {
+    FlushLocked();
+    actigraphy.Reset();
+  }
+  lastEpoch = epoch;
+
+  Actigraphy::Epoch scored;
+  if (actigraphy.Push(counts, scored)) {
+    uint32_t scoredEpoch = epoch - 2;
+    if (pendingSize > 0 && (scoredEpoch != pendingFirst + pendingSize || scoredEpoch % epochsPerDay == 0)) {
+      FlushLocked();
+    }
+    if (pendingSize == 0) {
+      pendingFirst = scoredEpoch;
+    }
+    pending[pendingSize++] = Encode(scored);
+    if (pendingSize == pending.size()) {
+      FlushLocked();
+    }
+  }
+  xSemaphoreGive(mutex);
+}
+
+void SleepTracker::Flush() {
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  FlushLocked();
+  xSemaphoreGive(mutex);
+}
+
+void SleepTracker::FlushLocked() {
+  if (pendingSize == 0) {
+    return;
+  }
+  uint32_t day = pendingFirst / epochsPerDay;
+  char path[24];
+  DayFilePath(day, path, sizeof(path));
+  lfs_file_t file;
+  // The epochs are mostly scored while the watch sleeps: wake the flash up once for the whole flush
+  fs.HoldFlash();
+  if (fs.FileOpen(&file, path, LFS_O_WRONLY) != LFS_ERR_OK) {
+    CreateDayFile(day);
+    if (fs.FileOpen(&file, path, LFS_O_WRONLY) != LFS_ERR_OK) {
+      NRF_LOG_WARNING("[SleepTracker] Failed to open %s", path);
+      fs.ReleaseFlash();
+      pendingSize = 0;
+      return;
+    }
+  }
+  // Skipped epochs are filled with zeros, which mark them missing
+  fs.FileSeek(&file, 1 + pendingFirst % epochsPerDay);
+  if (fs.FileWrite(&file, pending.data(), pendingSize) != static_cast<int>(pendingSize)) {
+    NRF_LOG_WARNING("[SleepTracker] Failed to write %s", path);
+  }
+  fs.FileClose(&file);
+  fs.ReleaseFlash();
+  pendingSize = 0;
+}
+
+void SleepTracker::CreateDayFile(uint32_t day) {
+  lfs_dir_t dir;
+  if (fs.DirOpen("/.system", &dir) != LFS_ERR_OK) {
+    fs.DirCreate("/.system");
+  } else {
+    fs.DirClose(&dir);
+  }
+  if (fs.DirOpen(directory, &dir) != LFS_ERR_OK) {
+    fs.DirCreate(directory);
+  } else {
+    // Delete the days that are no longer retained
+    char path[24];
+    lfs_info info;
+    while (fs.DirRead(&dir, &info) > 0) {
+      uint32_t fileDay = strtoul(info.name, nullptr, 10);
+      if (info.type == LFS_TYPE_REG && fileDay + maxDays <= day) {
+        DayFilePath(fileDay, path, sizeof(path));
+        fs.FileDelete(path);
+      }
+    }
+    fs.DirClose(&dir);
+  }
+
+  char path[24];
+  DayFilePath(day, path, sizeof(path));
+  lfs_file_t file;
+  if (fs.FileOpen(&file, path, LFS_O_WRONLY | LFS_O_CREAT) == LFS_ERR_OK) {
+    fs.FileWrite(&file, &version, 1);
+    fs.FileClose(&file);
+  }
+}
+
+size_t SleepTracker::Query(uint32_t from, uint32_t to, Sample* samples, size_t maxSamples) {
+  if (from > to || maxSamples == 0) {
+    return 0;
+  }
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  FlushLocked();
+
+  uint32_t today = Now() / secondsPerDay;
+  uint32_t firstDay = std::max(from / secondsPerDay, today >= maxDays ? today - maxDays + 1 : 0);
+  uint32_t lastDay = std::min(to / secondsPerDay, today);
+  size_t count = 0;
+  for (uint32_t day = firstDay; day <= lastDay && count < maxSamples; day++) {
+    char path[24];
+    DayFilePath(day, path, sizeof(path));
+    lfs_file_t file;
+    if (fs.FileOpen(&file, path, LFS_O_RDONLY) != LFS_ERR_OK) {
+      continue;
+    }
+    uint8_t header = 0;
+    if (fs.FileRead(&file, &header, 1) != 1 || header != version) {
+      fs.FileClose(&file);
+      continue;
+    }
+    uint32_t epoch = std::max(day * epochsPerDay, from / Actigraphy::epochDuration);
+    uint32_t lastEpochOfDay = std::min(day * epochsPerDay + epochsPerDay - 1, to / Actigraphy::epochDuration);
+    fs.FileSeek(&file, 1 + epoch % epochsPerDay);
+    std::array<uint8_t, 32> buffer;
+    int size;
+    while (epoch <= lastEpochOfDay && count < maxSamples && (size = fs.FileRead(&file, buffer.data(), buffer.size())) > 0) {
+      for (int i = 0; i < size && epoch <= lastEpochOfDay && count < maxSamples; i++, epoch++) {
+        if (buffer[i] != 0) {
+          samples[count++] = Decode(epoch, buffer[i]);
+        }
+      }
+    }
+    fs.FileClose(&file);
+  }
+  xSemaphoreGive(mutex);
+  return count;
+}
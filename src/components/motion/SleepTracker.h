@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include "components/motion/Actigraphy.h"
+
+namespace Pinetime {
+  namespace Controllers {
+    class FS;
+    class DateTime;
+    class MotionController;
+
+    // Sleep tracking from actigraphy: the motion counts of each 30s epoch are scored as sleep or wake, and stored on the flash.
+    // While the watch is still, the accelerometer only wakes the CPU on motion, so most epochs cost a single timer event.
+    // Each UTC day is a file in directory, made of a version byte followed by one byte per epoch of the day, at a fixed offset:
+    // 0 when the epoch is missing, else bit 7 set when awake, and bits 0-6 the counts on a logarithmic scale, plus 1.
+    class SleepTracker {
+    public:
+      struct Sample {
+        uint32_t timestamp; // UTC, seconds since epoch, start of the epoch
+        uint16_t counts;    // approximate
+        bool awake;
+      };
+
+      SleepTracker(FS& fs, DateTime& dateTimeController, MotionController& motionController);
+
+      // Ends the current epoch, should be called every Actigraphy::epochDuration seconds
+      void OnEpoch();
+      void Flush();
+
+      // Copies the scored epochs with from <= timestamp <= to in chronological order, and returns their number
+      size_t Query(uint32_t from, uint32_t to, Sample* samples, size_t maxSamples);
+
+    private:
+      static constexpr const char* directory = "/.system/sleep";
+      static constexpr uint8_t version = 1;
+      static constexpr uint32_t epochsPerDay = 24 * 60 * 60 / Actigraphy::epochDuration;
+      static constexpr uint32_t maxDays = 14;
+
+      static void DayFilePath(uint32_t day, char* path, size_t size);
+      static uint8_t Encode(const Actigraphy::Epoch& epoch);
+      static Sample Decode(uint32_t epoch, uint8_t value);
+      uint32_t Now();
+      void FlushLocked();
+      void CreateDayFile(uint32_t day);
+
+      FS& fs;
+      DateTime& dateTimeController;
+      MotionController& motionController;
+      SemaphoreHandle_t mutex;
+
+      Actigraphy actigraphy;
+      uint32_t lastEpoch = 0;
+      // Consecutive scored epochs of the same day, written in one go: at most every 30 minutes during the night
+      uint32_t pendingFirst = 0;
+      size_t pendingSize = 0;
+      std::array<uint8_t, 60> pending;
+    };
+  }
+}
@@ -4,7 +4,7 @@
 
 using namespace Pinetime::Controllers;
 
-Settings::Settings(Pinetime::Controllers::FS& fs) : fs {fs} {
+Settings::Settings(Pinetime::Controllers::FS& fs) : fs {fs}, store {fs} {
 }
 
 void Settings::Init() {
@@ -24,24 +24,26 @@ void Settings::SaveSettings() {
 
 void Settings::LoadSettingsFromFile() {
   SettingsData bufferSettings;
-  lfs_file_t settingsFile;
-
-  if (fs.FileOpen(&settingsFile, "/settings.dat", LFS_O_RDONLY) != LFS_ERR_OK) {
-    return;
+  static_assert(sizeof(bufferSettings) <= KeyValueStore::maxValueSize);
+
+  if (store.Get(KeyValueStore::Key::Settings, &bufferSettings, sizeof(bufferSettings)) != sizeof(bufferSettings)) {
+    // Settings saved to a file by previous versions, moved to the store
+    lfs_file_t settingsFile;
+    if (fs.FileOpen(&settingsFile, "/settings.dat", LFS_O_RDONLY) != LFS_ERR_OK) {
+      return;
+    }
+    fs.FileRead(&settingsFile, reinterpret_cast<uint8_t*>(&bufferSettings), sizeof(settings));
+    fs.FileClose(&settingsFile);
+    if (bufferSettings.version == settingsVersion &&
+        store.Set(KeyValueStore::Key::Settings, &bufferSettings, sizeof(bufferSettings)) == LFS_ERR_OK) {
+      fs.FileDelete("/settings.dat");
+    }
   }
-  fs.FileRead(&settingsFile, reinterpret_cast<uint8_t*>(&bufferSettings), sizeof(settings));
-  fs.FileClose(&settingsFile);
   if (bufferSettings.version == settingsVersion) {
     settings = bufferSettings;
   }
 }
 
 void Settings::SaveSettingsToFile() {
-  lfs_file_t settingsFile;
-
-  if (fs.FileOpen(&settingsFile, "/settings.dat", LFS_O_WRONLY | LFS_O_CREAT) != LFS_ERR_OK) {
-    return;
-  }
-  fs.FileWrite(&settingsFile, reinterpret_cast<uint8_t*>(&settings), sizeof(settings));
-  fs.FileClose(&settingsFile);
+  store.Set(KeyValueStore::Key::Settings, &settings, sizeof(settings));
 }
@@ -5,6 +5,7 @@
 #include <optional>
 #include "components/brightness/BrightnessController.h"
 #include "components/fs/FS.h"
+#include "components/fs/KeyValueStore.h"
 #include "displayapp/apps/Apps.h"
 #include <nrf_log.h>
 
@@ -353,6 +354,7 @@ namespace Pinetime {
 
     private:
       Pinetime::Controllers::FS& fs;
+      Pinetime::Controllers::KeyValueStore store;
 
       static constexpr uint32_t settingsVersion = 0x000a;
 
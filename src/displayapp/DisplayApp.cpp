@@ -300,6 +300,7 @@ void DisplayApp::Refresh() {
 
   Messages msg;
   if (xQueueReceive(msgQueue, &msg, queueTimeout) == pdTRUE) {
+    pendingMessages.Remove(msg);
     switch (msg) {
       case Messages::GoToSleep:
       case Messages::GoToAOD:
@@ -647,7 +648,9 @@ void DisplayApp::LoadScreen(Apps app, DisplayApp::FullRefreshDirections directio
                                                             watchdog,
                                                             motionController,
                                                             touchPanel,
-                                                            spiNorFlash);
+                                                            spiNorFlash,
+                                                            systemTask->GetRunTimeStats(),
+                                                            filesystem);
       break;
     case Apps::FlashLight:
       currentScreen = std::make_unique<Screens::FlashLight>(*systemTask, brightnessController);
@@ -668,9 +671,14 @@ void DisplayApp::LoadScreen(Apps app, DisplayApp::FullRefreshDirections directio
 }
 
 void DisplayApp::PushMessage(Messages msg) {
+  if (!pendingMessages.Add(msg)) {
+    return;
+  }
   if (in_isr()) {
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-    xQueueSendFromISR(msgQueue, &msg, &xHigherPriorityTaskWoken);
+    if (xQueueSendFromISR(msgQueue, &msg, &xHigherPriorityTaskWoken) != pdTRUE) {
+      pendingMessages.Remove(msg);
+    }
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
   } else {
     TickType_t timeout = portMAX_DELAY;
@@ -681,7 +689,9 @@ void DisplayApp::PushMessage(Messages msg) {
       timeout = static_cast<TickType_t>(0);
     }
 
-    xQueueSend(msgQueue, &msg, timeout);
+    if (xQueueSend(msgQueue, &msg, timeout) != pdTRUE) {
+      pendingMessages.Remove(msg);
+    }
   }
 }
 
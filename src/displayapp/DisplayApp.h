@@ -21,6 +21,7 @@
 #include "BootErrors.h"
 
 #include "utility/StaticStack.h"
+#include "utility/PendingMessages.h"
 #include "displayapp/Controllers.h"
 
 namespace Pinetime {
@@ -116,6 +117,10 @@ namespace Pinetime {
 
       States state = States::Running;
       QueueHandle_t msgQueue;
+      // These messages are handled with the latest state, a second one waiting in the queue would do nothing
+      Utility::PendingMessages<Display::Messages> pendingMessages {Display::Messages::TouchEvent,
+                                                                   Display::Messages::NotifyDeviceActivity,
+                                                                   Display::Messages::UpdateBleConnection};
 
       static constexpr uint8_t queueSize = 10;
       static constexpr uint8_t itemSize = 1;
@@ -6,6 +6,7 @@
 #include "drivers/St7789.h"
 #include "littlefs/lfs.h"
 #include "components/fs/FS.h"
+#include "utility/Trace.h"
 
 using namespace Pinetime::Components;
 
@@ -51,6 +52,49 @@ namespace {
     filesys->FileSeek(file, pos);
     return LV_FS_RES_OK;
   }
+
+  // Read-only driver of the resources, from the resource pack or else from their own file
+  lv_fs_res_t resourceOpen(lv_fs_drv_t* drv, void* file_p, const char* path, lv_fs_mode_t mode) {
+    if (mode != LV_FS_MODE_RD) {
+      return LV_FS_RES_DENIED;
+    }
+    auto* pack = static_cast<Pinetime::Controllers::ResourcePack*>(drv->user_data);
+    auto* file = static_cast<Pinetime::Controllers::ResourcePack::File*>(file_p);
+    if (pack->Open(*file, path) != LFS_ERR_OK) {
+      return LV_FS_RES_NOT_EX;
+    }
+    return LV_FS_RES_OK;
+  }
+
+  lv_fs_res_t resourceClose(lv_fs_drv_t* drv, void* file_p) {
+    auto* pack = static_cast<Pinetime::Controllers::ResourcePack*>(drv->user_data);
+    pack->Close(*static_cast<Pinetime::Controllers::ResourcePack::File*>(file_p));
+    return LV_FS_RES_OK;
+  }
+
+  lv_fs_res_t resourceRead(lv_fs_drv_t* drv, void* file_p, void* buf, uint32_t btr, uint32_t* br) {
+    auto* pack = static_cast<Pinetime::Controllers::ResourcePack*>(drv->user_data);
+    int read = pack->Read(*static_cast<Pinetime::Controllers::ResourcePack::File*>(file_p), static_cast<uint8_t*>(buf), btr);
+    if (read < 0) {
+      *br = 0;
+      return LV_FS_RES_FS_ERR;
+    }
+    *br = read;
+    return LV_FS_RES_OK;
+  }
+
+  lv_fs_res_t resourceSeek(lv_fs_drv_t* drv, void* file_p, uint32_t pos) {
+    auto* pack = static_cast<Pinetime::Controllers::ResourcePack*>(drv->user_data);
+    if (pack->Seek(*static_cast<Pinetime::Controllers::ResourcePack::File*>(file_p), pos) < 0) {
+      return LV_FS_RES_FS_ERR;
+    }
+    return LV_FS_RES_OK;
+  }
+
+  lv_fs_res_t resourceTell(lv_fs_drv_t* /*drv*/, void* file_p, uint32_t* pos_p) {
+    *pos_p = static_cast<Pinetime::Controllers::ResourcePack::File*>(file_p)->position;
+    return LV_FS_RES_OK;
+  }
 }
 
 static void disp_flush(lv_disp_drv_t* disp_drv, const lv_area_t* area, lv_color_t* color_p) {
@@ -73,7 +117,8 @@ bool touchpad_read(lv_indev_drv_t* indev_drv, lv_indev_data_t* data) {
   return lvgl->GetTouchPadInfo(data);
 }
 
-LittleVgl::LittleVgl(Pinetime::Drivers::St7789& lcd, Pinetime::Controllers::FS& filesystem) : lcd {lcd}, filesystem {filesystem} {
+LittleVgl::LittleVgl(Pinetime::Drivers::St7789& lcd, Pinetime::Controllers::FS& filesystem)
+  : lcd {lcd}, filesystem {filesystem}, resourcePack {filesystem} {
 }
 
 void LittleVgl::Init() {
@@ -129,6 +174,21 @@ void LittleVgl::InitFileSystem() {
   fs_drv.user_data = &filesystem;
 
   lv_fs_drv_register(&fs_drv);
+
+  lv_fs_drv_t resource_drv;
+  lv_fs_drv_init(&resource_drv);
+
+  resource_drv.file_size = sizeof(Pinetime::Controllers::ResourcePack::File);
+  resource_drv.letter = 'R';
+  resource_drv.open_cb = resourceOpen;
+  resource_drv.close_cb = resourceClose;
+  resource_drv.read_cb = resourceRead;
+  resource_drv.seek_cb = resourceSeek;
+  resource_drv.tell_cb = resourceTell;
+
+  resource_drv.user_data = &resourcePack;
+
+  lv_fs_drv_register(&resource_drv);
 }
 
 void LittleVgl::SetFullRefresh(FullRefreshDirections direction) {
@@ -155,6 +215,7 @@ bool LittleVgl::IsScrolling() {
 
 void LittleVgl::FlushDisplay(const lv_area_t* area, lv_color_t* color_p) {
   uint16_t y1, y2, width, height = 0;
+  Utility::Trace::Record(Utility::Trace::Event::DisplayFlushStart, (area->y1 << 16) | (area->y2 - area->y1 + 1));
 
   if ((scrollDirection == LittleVgl::FullRefreshDirections::Down) && (area->y2 == visibleNbLines - 1)) {
     writeOffset = ((writeOffset + totalNbLines) - visibleNbLines) % totalNbLines;
@@ -229,6 +290,8 @@ void LittleVgl::FlushDisplay(const lv_area_t* area, lv_color_t* color_p) {
     lcd.DrawBuffer(area->x1, y1, width, height, reinterpret_cast<const uint8_t*>(color_p), width * height * 2);
   }
 
+  Utility::Trace::Record(Utility::Trace::Event::DisplayFlushEnd);
+
   // IMPORTANT!!!
   // Inform the graphics library that you are ready with the flushing
   lv_disp_flush_ready(&disp_drv);
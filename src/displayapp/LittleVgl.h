@@ -2,6 +2,7 @@
 
 #include <lvgl/lvgl.h>
 #include <components/fs/FS.h>
+#include <components/fs/ResourcePack.h>
 
 namespace Pinetime {
   namespace Drivers {
@@ -44,6 +45,7 @@ namespace Pinetime {
 
       Pinetime::Drivers::St7789& lcd;
       Pinetime::Controllers::FS& filesystem;
+      Pinetime::Controllers::ResourcePack resourcePack;
 
       lv_disp_buf_t disp_buf_2;
       lv_color_t buf2_1[LV_HOR_RES_MAX * 4];
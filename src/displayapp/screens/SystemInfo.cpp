@@ -11,8 +11,11 @@
 #include "components/ble/BleController.h"
 #include "components/brightness/BrightnessController.h"
 #include "components/datetime/DateTimeController.h"
+#include "components/fs/FS.h"
 #include "components/motion/MotionController.h"
 #include "drivers/Watchdog.h"
+#include "systemtask/RunTimeStats.h"
+#include "utility/FlashTelemetry.h"
 #include "displayapp/InfiniTimeTheme.h"
 
 using namespace Pinetime::Applications::Screens;
@@ -29,6 +32,11 @@ namespace {
     }
     return "???";
   }
+
+  // Average latency, in 10us
+  uint32_t AverageLatency(const Pinetime::Utility::FlashTelemetry::Counters& counters) {
+    return static_cast<uint64_t>(counters.ticks) * 100000 / 32768 / std::max<uint32_t>(counters.count, 1);
+  }
 }
 
 SystemInfo::SystemInfo(Pinetime::Applications::DisplayApp* app,
@@ -39,7 +47,9 @@ SystemInfo::SystemInfo(Pinetime::Applications::DisplayApp* app,
                        const Pinetime::Drivers::Watchdog& watchdog,
                        Pinetime::Controllers::MotionController& motionController,
                        const Pinetime::Drivers::Cst816S& touchPanel,
-                       const Pinetime::Drivers::SpiNorFlash& spiNorFlash)
+                       const Pinetime::Drivers::SpiNorFlash& spiNorFlash,
+                       const Pinetime::System::RunTimeStats& runTimeStats,
+                       Pinetime::Controllers::FS& filesystem)
   : dateTimeController {dateTimeController},
     batteryController {batteryController},
     brightnessController {brightnessController},
@@ -48,6 +58,8 @@ SystemInfo::SystemInfo(Pinetime::Applications::DisplayApp* app,
     motionController {motionController},
     touchPanel {touchPanel},
     spiNorFlash {spiNorFlash},
+    runTimeStats {runTimeStats},
+    filesystem {filesystem},
     screens {app,
              0,
              {[this]() -> std::unique_ptr<Screen> {
@@ -64,6 +76,12 @@ SystemInfo::SystemInfo(Pinetime::Applications::DisplayApp* app,
               },
               [this]() -> std::unique_ptr<Screen> {
                 return CreateScreen5();
+              },
+              [this]() -> std::unique_ptr<Screen> {
+                return CreateScreen6();
+              },
+              [this]() -> std::unique_ptr<Screen> {
+                return CreateScreen7();
               }},
              Screens::ScreenListModes::UpDown} {
 }
@@ -96,7 +114,7 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen1() {
                         BootloaderVersion::VersionString());
   lv_label_set_align(label, LV_LABEL_ALIGN_CENTER);
   lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
-  return std::make_unique<Screens::Label>(0, 5, label);
+  return std::make_unique<Screens::Label>(0, 7, label);
 }
 
 std::unique_ptr<Screen> SystemInfo::CreateScreen2() {
@@ -175,7 +193,7 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen2() {
                         touchPanel.GetFwVersion(),
                         TARGET_DEVICE_NAME);
   lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
-  return std::make_unique<Screens::Label>(1, 5, label);
+  return std::make_unique<Screens::Label>(1, 7, label);
 }
 
 extern int mallocFailedCount;
@@ -214,7 +232,7 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen3() {
                         mallocFailedCount,
                         stackOverflowCount);
   lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
-  return std::make_unique<Screens::Label>(2, 5, label);
+  return std::make_unique<Screens::Label>(2, 7, label);
 }
 
 bool SystemInfo::sortById(const TaskStatus_t& lhs, const TaskStatus_t& rhs) {
@@ -280,10 +298,83 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen4() {
     }
     lv_table_set_cell_value(infoTask, i + 1, 3, buffer);
   }
-  return std::make_unique<Screens::Label>(3, 5, infoTask);
+  return std::make_unique<Screens::Label>(3, 7, infoTask);
 }
 
 std::unique_ptr<Screen> SystemInfo::CreateScreen5() {
+  // The busiest tasks, and the idle time of the CPU, sleep included
+  static constexpr uint8_t maxTaskCount = 8;
+  auto stats = runTimeStats.Latest();
+  uint8_t nb = std::min(stats.nbTasks, maxTaskCount);
+
+  lv_obj_t* infoTask = lv_table_create(lv_scr_act(), nullptr);
+  lv_table_set_col_cnt(infoTask, 3);
+  lv_table_set_row_cnt(infoTask, nb + 2);
+  lv_obj_set_style_local_pad_all(infoTask, LV_TABLE_PART_CELL1, LV_STATE_DEFAULT, 0);
+  lv_obj_set_style_local_border_color(infoTask, LV_TABLE_PART_CELL1, LV_STATE_DEFAULT, Colors::lightGray);
+
+  lv_table_set_cell_value(infoTask, 0, 0, "Task");
+  lv_table_set_col_width(infoTask, 0, 80);
+  lv_table_set_cell_value(infoTask, 0, 1, "CPU");
+  lv_table_set_col_width(infoTask, 1, 80);
+  lv_table_set_cell_value(infoTask, 0, 2, "Wk/m"); // Wakeups per minute
+  lv_table_set_col_width(infoTask, 2, 70);
+
+  char buffer[11] = {0};
+  for (uint8_t i = 0; i < nb; i++) {
+    const auto& task = stats.tasks[i];
+    lv_table_set_cell_value(infoTask, i + 1, 0, task.name);
+    snprintf(buffer, sizeof(buffer), "%u.%u%%", task.load / 10, task.load % 10);
+    lv_table_set_cell_value(infoTask, i + 1, 1, buffer);
+    snprintf(buffer, sizeof(buffer), "%" PRIu32, static_cast<uint32_t>(task.wakeups) * 60000 / std::max<uint32_t>(stats.period, 1));
+    lv_table_set_cell_value(infoTask, i + 1, 2, buffer);
+  }
+  lv_table_set_cell_value(infoTask, nb + 1, 0, "Idle");
+  snprintf(buffer, sizeof(buffer), "%u.%u%%", stats.idle / 10, stats.idle % 10);
+  lv_table_set_cell_value(infoTask, nb + 1, 1, buffer);
+  return std::make_unique<Screens::Label>(4, 7, infoTask);
+}
+
+std::unique_ptr<Screen> SystemInfo::CreateScreen6() {
+  // The block device operations of the file system since boot, and the wear of the blocks
+  using Pinetime::Utility::FlashTelemetry::Operation;
+  auto read = Pinetime::Utility::FlashTelemetry::Total(Operation::BlockRead);
+  auto prog = Pinetime::Utility::FlashTelemetry::Total(Operation::BlockProg);
+  auto erase = Pinetime::Utility::FlashTelemetry::Total(Operation::BlockErase);
+  auto sync = Pinetime::Utility::FlashTelemetry::Total(Operation::BlockSync);
+  auto wear = filesystem.GetWear();
+
+  lv_obj_t* label = lv_label_create(lv_scr_act(), nullptr);
+  lv_label_set_recolor(label, true);
+  lv_label_set_text_fmt(label,
+                        "#808080 Flash# count, avg\n"
+                        " #808080 Read# %" PRIu32 " %" PRIu32 ".%02" PRIu32 "ms\n"
+                        " #808080 Prog# %" PRIu32 " %" PRIu32 ".%02" PRIu32 "ms\n"
+                        " #808080 Erase# %" PRIu32 " %" PRIu32 ".%02" PRIu32 "ms\n"
+                        " #808080 Sync# %" PRIu32 " %" PRIu32 ".%02" PRIu32 "ms\n"
+                        "\n"
+                        "#808080 Wear#\n"
+                        " #808080 Erases# %" PRIu32 "\n"
+                        " #808080 Max/block# %" PRIu32,
+                        read.count,
+                        AverageLatency(read) / 100,
+                        AverageLatency(read) % 100,
+                        prog.count,
+                        AverageLatency(prog) / 100,
+                        AverageLatency(prog) % 100,
+                        erase.count,
+                        AverageLatency(erase) / 100,
+                        AverageLatency(erase) % 100,
+                        sync.count,
+                        AverageLatency(sync) / 100,
+                        AverageLatency(sync) % 100,
+                        wear.erases,
+                        wear.maxErases);
+  lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
+  return std::make_unique<Screens::Label>(5, 7, label);
+}
+
+std::unique_ptr<Screen> SystemInfo::CreateScreen7() {
   lv_obj_t* label = lv_label_create(lv_scr_act(), nullptr);
   lv_label_set_recolor(label, true);
   lv_label_set_text_static(label,
@@ -297,5 +388,5 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen5() {
                            "#FFFF00 InfiniTime#");
   lv_label_set_align(label, LV_LABEL_ALIGN_CENTER);
   lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
-  return std::make_unique<Screens::Label>(4, 5, label);
+  return std::make_unique<Screens::Label>(6, 7, label);
 }
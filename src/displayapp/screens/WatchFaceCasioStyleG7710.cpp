@@ -1,4 +1,5 @@
 #include "displayapp/screens/WatchFaceCasioStyleG7710.h"
+#include "components/fs/ResourcePack.h"
 
 #include <lvgl/lvgl.h>
 #include <cstdio>
@@ -32,20 +33,17 @@ WatchFaceCasioStyleG7710::WatchFaceCasioStyleG7710(Controllers::DateTime& dateTi
     heartRateController {heartRateController},
     motionController {motionController} {
 
-  lfs_file f = {};
-  if (filesystem.FileOpen(&f, "/fonts/lv_font_dots_40.bin", LFS_O_RDONLY) >= 0) {
-    filesystem.FileClose(&f);
-    font_dot40 = lv_font_load("F:/fonts/lv_font_dots_40.bin");
+  Pinetime::Controllers::ResourcePack resources {filesystem};
+  if (resources.Exists("/fonts/lv_font_dots_40.bin")) {
+    font_dot40 = lv_font_load("R:/fonts/lv_font_dots_40.bin");
   }
 
-  if (filesystem.FileOpen(&f, "/fonts/7segments_40.bin", LFS_O_RDONLY) >= 0) {
-    filesystem.FileClose(&f);
-    font_segment40 = lv_font_load("F:/fonts/7segments_40.bin");
+  if (resources.Exists("/fonts/7segments_40.bin")) {
+    font_segment40 = lv_font_load("R:/fonts/7segments_40.bin");
   }
 
-  if (filesystem.FileOpen(&f, "/fonts/7segments_115.bin", LFS_O_RDONLY) >= 0) {
-    filesystem.FileClose(&f);
-    font_segment115 = lv_font_load("F:/fonts/7segments_115.bin");
+  if (resources.Exists("/fonts/7segments_115.bin")) {
+    font_segment115 = lv_font_load("R:/fonts/7segments_115.bin");
   }
 
   label_battery_value = lv_label_create(lv_scr_act(), nullptr);
@@ -313,22 +311,7 @@ void WatchFaceCasioStyleG7710::Refresh() {
 }
 
 bool WatchFaceCasioStyleG7710::IsAvailable(Pinetime::Controllers::FS& filesystem) {
-  lfs_file file = {};
-
-  if (filesystem.FileOpen(&file, "/fonts/lv_font_dots_40.bin", LFS_O_RDONLY) < 0) {
-    return false;
-  }
-
-  filesystem.FileClose(&file);
-  if (filesystem.FileOpen(&file, "/fonts/7segments_40.bin", LFS_O_RDONLY) < 0) {
-    return false;
-  }
-
-  filesystem.FileClose(&file);
-  if (filesystem.FileOpen(&file, "/fonts/7segments_115.bin", LFS_O_RDONLY) < 0) {
-    return false;
-  }
-
-  filesystem.FileClose(&file);
-  return true;
+  Pinetime::Controllers::ResourcePack resources {filesystem};
+  return resources.Exists("/fonts/lv_font_dots_40.bin") && resources.Exists("/fonts/7segments_40.bin") &&
+         resources.Exists("/fonts/7segments_115.bin");
 }
@@ -1,4 +1,5 @@
 #include "displayapp/screens/WatchFaceInfineat.h"
+#include "components/fs/ResourcePack.h"
 
 #include <lvgl/lvgl.h>
 #include <cstdio>
@@ -133,15 +134,13 @@ WatchFaceInfineat::WatchFaceInfineat(Controllers::DateTime& dateTimeController,
     notificationManager {notificationManager},
     settingsController {settingsController},
     motionController {motionController} {
-  lfs_file f = {};
-  if (filesystem.FileOpen(&f, "/fonts/teko.bin", LFS_O_RDONLY) >= 0) {
-    filesystem.FileClose(&f);
-    font_teko = lv_font_load("F:/fonts/teko.bin");
+  Pinetime::Controllers::ResourcePack resources {filesystem};
+  if (resources.Exists("/fonts/teko.bin")) {
+    font_teko = lv_font_load("R:/fonts/teko.bin");
   }
 
-  if (filesystem.FileOpen(&f, "/fonts/bebas.bin", LFS_O_RDONLY) >= 0) {
-    filesystem.FileClose(&f);
-    font_bebas = lv_font_load("F:/fonts/bebas.bin");
+  if (resources.Exists("/fonts/bebas.bin")) {
+    font_bebas = lv_font_load("R:/fonts/bebas.bin");
   }
 
   // Side Cover
@@ -167,7 +166,7 @@ WatchFaceInfineat::WatchFaceInfineat(Controllers::DateTime& dateTimeController,
   }
 
   logoPine = lv_img_create(lv_scr_act(), nullptr);
-  lv_img_set_src(logoPine, "F:/images/pine_small.bin");
+  lv_img_set_src(logoPine, "R:/images/pine_small.bin");
   lv_obj_set_pos(logoPine, 15, 106);
 
   lineBattery = lv_line_create(lv_scr_act(), nullptr);
@@ -491,22 +490,6 @@ void WatchFaceInfineat::ToggleBatteryIndicatorColor(bool showSideCover) {
 }
 
 bool WatchFaceInfineat::IsAvailable(Pinetime::Controllers::FS& filesystem) {
-  lfs_file file = {};
-
-  if (filesystem.FileOpen(&file, "/fonts/teko.bin", LFS_O_RDONLY) < 0) {
-    return false;
-  }
-
-  filesystem.FileClose(&file);
-  if (filesystem.FileOpen(&file, "/fonts/bebas.bin", LFS_O_RDONLY) < 0) {
-    return false;
-  }
-
-  filesystem.FileClose(&file);
-  if (filesystem.FileOpen(&file, "/images/pine_small.bin", LFS_O_RDONLY) < 0) {
-    return false;
-  }
-
-  filesystem.FileClose(&file);
-  return true;
+  Pinetime::Controllers::ResourcePack resources {filesystem};
+  return resources.Exists("/fonts/teko.bin") && resources.Exists("/fonts/bebas.bin") && resources.Exists("/images/pine_small.bin");
 }
@@ -1,4 +1,5 @@
 #include "drivers/Bma421.h"
+#include <algorithm>
 #include <libraries/delay/nrf_delay.h>
 #include <libraries/log/nrf_log.h>
 #include "drivers/TwiMaster.h"
@@ -93,6 +94,70 @@ void Bma421::Init() {
     return;
 
   isOk = true;
+  isFifoEnabled = InitFifo();
+  areFeatureInterruptsEnabled = isFifoEnabled && InitFeatureInterrupts();
+}
+
+bool Bma421::InitFifo() {
+  // Accelerometer frames only, without header: 6 bytes per sample
+  auto ret = bma4_set_fifo_config(BMA4_FIFO_ALL, 0, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  ret = bma4_set_fifo_config(BMA4_FIFO_ACCEL, 1, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  // The sensor keeps running at 100Hz for the step counter, the FIFO stores the filtered data at 100Hz / 2^3
+  ret = bma4_set_accel_fifo_filter_data(1, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  ret = bma4_set_fifo_down_accel(3, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  ret = bma4_set_fifo_wm(fifoWatermark * BMA4_FIFO_A_LENGTH, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  struct bma4_int_pin_config pinConfig = {};
+  pinConfig.edge_ctrl = BMA4_EDGE_TRIGGER;
+  pinConfig.lvl = BMA4_ACTIVE_HIGH;
+  pinConfig.od = BMA4_PUSH_PULL;
+  pinConfig.output_en = BMA4_OUTPUT_ENABLE;
+  pinConfig.input_en = BMA4_INPUT_DISABLE;
+  ret = bma4_set_int_pin_config(&pinConfig, BMA4_INTR1_MAP, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  ret = bma423_map_interrupt(BMA4_INTR1_MAP, BMA4_FIFO_WM_INT, 1, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  // Flush the FIFO
+  ret = bma4_set_command_register(0xB0, &bma);
+  return ret == BMA4_OK;
+}
+
+bool Bma421::InitFeatureInterrupts() {
+  // The features run continuously, MapFeatureInterrupts() only selects the ones that raise INT1
+  auto ret = bma423_feature_enable(BMA423_WRIST_WEAR, 1, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  // Strong movements only (slope above 250mg for 100ms): they trigger the software shake detection
+  struct bma423_any_no_mot_config anyMotion;
+  anyMotion.duration = 5;
+  anyMotion.threshold = 512;
+  anyMotion.axes_en = BMA423_EN_ALL_AXIS;
+  ret = bma423_set_any_mot_config(&anyMotion, &bma);
+  if (ret != BMA4_OK)
+    return false;
+
+  // Interrupt every 20 steps
+  ret = bma423_step_counter_set_watermark(1, &bma);
+  return ret == BMA4_OK;
 }
 
 void Bma421::Reset() {
@@ -130,10 +195,100 @@ Bma421::Values Bma421::Process() {
   return {steps, data.y, data.x, data.z};
 }
 
+void Bma421::SetFifoWatermark(uint8_t samples) {
+  samples = std::min(samples, maxFifoSamples);
+  if (not isFifoEnabled or samples == currentFifoWatermark)
+    return;
+
+  if (bma4_set_fifo_wm(samples * BMA4_FIFO_A_LENGTH, &bma) == BMA4_OK)
+    currentFifoWatermark = samples;
+}
+
+uint8_t Bma421::ReadFifo(Values* values, uint8_t maxValues, bool* wristTilt) {
+  if (not isFifoEnabled)
+    return 0;
+
+  // Interrupt status (which clears the latched interrupt), step counter and FIFO length are read in a single burst
+  constexpr uint8_t statusLength = BMA4_FIFO_LENGTH_0_ADDR + 2 - BMA4_INT_STAT_0_ADDR;
+  uint8_t status[statusLength];
+  Read(BMA4_INT_STAT_0_ADDR, status, statusLength);
+  const uint8_t* stepData = &status[BMA4_STEP_CNT_OUT_0_ADDR - BMA4_INT_STAT_0_ADDR];
+  uint32_t steps = stepData[0] | (stepData[1] << 8) | (stepData[2] << 16) | (static_cast<uint32_t>(stepData[3]) << 24);
+  const uint8_t* lengthData = &status[BMA4_FIFO_LENGTH_0_ADDR - BMA4_INT_STAT_0_ADDR];
+  uint16_t fifoLength = lengthData[0] | ((lengthData[1] & BMA4_FIFO_BYTE_COUNTER_MSB_MSK) << 8);
+  if (wristTilt != nullptr)
+    *wristTilt = (status[0] & BMA423_WRIST_WEAR_INT) != 0;
+
+  uint8_t count = std::min<uint16_t>(fifoLength / BMA4_FIFO_A_LENGTH, std::min<uint8_t>(maxValues, maxFifoSamples));
+  if (count == 0)
+    return 0;
+
+  struct bma4_fifo_frame fifo = {};
+  fifo.data = fifoBuffer.data();
+  fifo.length = count * BMA4_FIFO_A_LENGTH;
+  fifo.fifo_header_enable = 0;
+  fifo.fifo_data_enable = BMA4_FIFO_A_ENABLE;
+  Read(BMA4_FIFO_DATA_ADDR, fifo.data, fifo.length);
+
+  struct bma4_accel rawData[maxFifoSamples];
+  uint16_t rawCount = count;
+  bma4_extract_accel(rawData, &rawCount, &fifo, &bma);
+
+  for (uint8_t i = 0; i < rawCount; i++) {
+    // Same scaling and axis swap as Process()
+    int16_t x = 1024 * rawData[i].x / accelScaleFactors[accel_conf.range];
+    int16_t y = 1024 * rawData[i].y / accelScaleFactors[accel_conf.range];
+    int16_t z = 1024 * rawData[i].z / accelScaleFactors[accel_conf.range];
+    values[i] = {steps, y, x, z};
+  }
+  return rawCount;
+}
+
+void Bma421::MapFeatureInterrupts(bool wristTilt, bool anyMotion) {
+  if (not areFeatureInterruptsEnabled)
+    return;
+
+  uint16_t enabled = BMA423_STEP_CNTR_INT;
+  if (wristTilt)
+    enabled |= BMA423_WRIST_WEAR_INT;
+  if (anyMotion)
+    enabled |= BMA423_ANY_MOT_INT;
+  // Mapping replaces all the interrupts of the line, which also unmaps the FIFO watermark
+  bma423_map_interrupt(BMA4_INTR1_MAP, enabled, 1, &bma);
+}
+
+void Bma421::MapFifoInterrupt(bool wristTilt) {
+  if (not areFeatureInterruptsEnabled)
+    return;
+
+  bma4_set_command_register(0xB0, &bma);
+  bma423_map_interrupt(BMA4_INTR1_MAP, BMA4_FIFO_WM_INT | (wristTilt ? BMA423_WRIST_WEAR_INT : 0), 1, &bma);
+}
+
+Bma421::FeatureEvents Bma421::ReadFeatureEvents() {
+  if (not areFeatureInterruptsEnabled)
+    return {};
+
+  constexpr uint8_t length = BMA4_STEP_CNT_OUT_0_ADDR + 4 - BMA4_INT_STAT_0_ADDR;
+  uint8_t data[length];
+  Read(BMA4_INT_STAT_0_ADDR, data, length);
+  const uint8_t* stepData = &data[BMA4_STEP_CNT_OUT_0_ADDR - BMA4_INT_STAT_0_ADDR];
+  uint32_t steps = stepData[0] | (stepData[1] << 8) | (stepData[2] << 16) | (static_cast<uint32_t>(stepData[3]) << 24);
+  return {steps, (data[0] & BMA423_WRIST_WEAR_INT) != 0, (data[0] & BMA423_ANY_MOT_INT) != 0};
+}
+
 bool Bma421::IsOk() const {
   return isOk;
 }
 
+bool Bma421::IsFifoEnabled() const {
+  return isFifoEnabled;
+}
+
+bool Bma421::AreFeatureInterruptsEnabled() const {
+  return areFeatureInterruptsEnabled;
+}
+
 void Bma421::ResetStepCounter() {
   bma423_reset_step_counter(&bma);
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <drivers/Bma421_C/bma4_defs.h>
 
 namespace Pinetime {
@@ -16,6 +17,12 @@ namespace Pinetime {
         int16_t z;
       };
 
+      struct FeatureEvents {
+        uint32_t steps;
+        bool wristTilt;
+        bool anyMotion;
+      };
+
       Bma421(TwiMaster& twiMaster, uint8_t twiAddress);
       Bma421(const Bma421&) = delete;
       Bma421& operator=(const Bma421&) = delete;
@@ -27,16 +34,40 @@ namespace Pinetime {
       void SoftReset();
       void Init();
       Values Process();
+      /// Drains up to maxValues samples from the FIFO, oldest first, using two bus transactions.
+      /// All the samples carry the current step count. Returns the number of samples read.
+      /// wristTilt, when given, tells whether the wrist tilt interrupt was raised since the previous read.
+      uint8_t ReadFifo(Values* values, uint8_t maxValues, bool* wristTilt = nullptr);
+      /// Number of samples stored before the FIFO watermark interrupt is raised, at most maxFifoSamples
+      void SetFifoWatermark(uint8_t samples);
+
+      /// Routes the wrist tilt, any-motion and step counter interrupts to INT1 instead of the FIFO watermark,
+      /// so that no samples need to be read while the system is sleeping.
+      void MapFeatureInterrupts(bool wristTilt, bool anyMotion);
+      /// Routes the FIFO watermark interrupt back to INT1, after discarding the samples stored in the meantime.
+      /// With wristTilt, the wrist tilt interrupt stays routed too, and is reported by ReadFifo().
+      void MapFifoInterrupt(bool wristTilt = false);
+      /// Reads (and clears) the feature interrupt status and the step counter in a single transaction.
+      FeatureEvents ReadFeatureEvents();
       void ResetStepCounter();
 
       void Read(uint8_t registerAddress, uint8_t* buffer, size_t size);
       void Write(uint8_t registerAddress, const uint8_t* data, size_t size);
 
       bool IsOk() const;
+      bool IsFifoEnabled() const;
+      bool AreFeatureInterruptsEnabled() const;
       DeviceTypes DeviceType() const;
 
+      // In FIFO mode, samples are stored at 12.5Hz and the interrupt pin is raised every fifoWatermark samples
+      static constexpr uint8_t fifoWatermark = 10;
+      static constexpr uint8_t fifoSamplePeriodMs = 80;
+      static constexpr uint8_t maxFifoSamples = 12;
+
     private:
       void Reset();
+      bool InitFifo();
+      bool InitFeatureInterrupts();
 
       TwiMaster& twiMaster;
       uint8_t deviceAddress = 0x18;
@@ -44,6 +75,10 @@ namespace Pinetime {
       struct bma4_accel_config accel_conf; // Store the device configuration for later reference.
       bool isOk = false;
       bool isResetOk = false;
+      bool isFifoEnabled = false;
+      bool areFeatureInterruptsEnabled = false;
+      uint8_t currentFifoWatermark = fifoWatermark;
+      std::array<uint8_t, maxFifoSamples * BMA4_FIFO_A_LENGTH> fifoBuffer;
       DeviceTypes deviceType = DeviceTypes::Unknown;
     };
   }
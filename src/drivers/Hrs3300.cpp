@@ -7,6 +7,7 @@
 #include "drivers/Hrs3300.h"
 #include <algorithm>
 #include <iterator>
+#include <limits>
 #include <nrf_gpio.h>
 
 #include <FreeRTOS.h>
@@ -17,6 +18,29 @@ using namespace Pinetime::Drivers;
 
 namespace {
   static constexpr uint8_t ledDriveCurrentValue = 0x2f;
+
+  // Values read from the sensor are scaled to this resolution, so that they don't depend on the profile
+  constexpr uint8_t referenceResolutionBits = 15;
+
+  constexpr Hrs3300::Profile profiles[] = {
+    // Standard: the configuration set by Init()
+    {Hrs3300::WaitTime::Wait50ms, Hrs3300::Resolution::Resolution15Bit, Hrs3300::LedCurrent::Current12_5mA, Hrs3300::Gain::Gain1x},
+    // Boosted and Maximum: for weak signals
+    {Hrs3300::WaitTime::Wait50ms, Hrs3300::Resolution::Resolution15Bit, Hrs3300::LedCurrent::Current12_5mA, Hrs3300::Gain::Gain2x},
+    {Hrs3300::WaitTime::Wait50ms, Hrs3300::Resolution::Resolution15Bit, Hrs3300::LedCurrent::Current20mA, Hrs3300::Gain::Gain2x},
+  };
+
+  constexpr uint8_t ResolutionBits(Hrs3300::Resolution resolution) {
+    switch (resolution) {
+      case Hrs3300::Resolution::Resolution14Bit:
+        return 14;
+      case Hrs3300::Resolution::Resolution15Bit:
+        return 15;
+      case Hrs3300::Resolution::Resolution16Bit:
+        return 16;
+    }
+    return referenceResolutionBits;
+  }
 }
 
 /** Driver for the HRS3300 heart rate sensor.
@@ -34,7 +58,8 @@ void Hrs3300::Init() {
   vTaskDelay(100);
 
   // HRS disabled, 50ms wait time between ADC conversion period, current 12.5mA
-  WriteRegister(static_cast<uint8_t>(Registers::Enable), 0x50);
+  enableValue = 0x50;
+  WriteRegister(static_cast<uint8_t>(Registers::Enable), enableValue);
 
   // Current 12.5mA and low nibble 0xF.
   // Note: Setting low nibble to 0x8 per the datasheet results in
@@ -44,26 +69,26 @@ void Hrs3300::Init() {
 
   // HRS and ALS both in 15-bit mode results in ~50ms LED drive period
   // and presumably ~50ms ADC conversion period.
+  resolution = Resolution::Resolution15Bit;
   WriteRegister(static_cast<uint8_t>(Registers::Res), 0x77);
 
   // Gain set to 1x
-  WriteRegister(static_cast<uint8_t>(Registers::Hgain), 0x00);
+  hgainValue = 0x00;
+  WriteRegister(static_cast<uint8_t>(Registers::Hgain), hgainValue);
+  ledCurrent = LedCurrent::Current12_5mA;
 }
 
 void Hrs3300::Enable() {
   NRF_LOG_INFO("ENABLE");
-  auto value = ReadRegister(static_cast<uint8_t>(Registers::Enable));
-  value |= 0x80;
-  WriteRegister(static_cast<uint8_t>(Registers::Enable), value);
-
-  WriteRegister(static_cast<uint8_t>(Registers::PDriver), ledDriveCurrentValue);
+  enableValue |= 0x80;
+  WriteRegister(static_cast<uint8_t>(Registers::Enable), enableValue);
+  WritePDriver();
 }
 
 void Hrs3300::Disable() {
   NRF_LOG_INFO("DISABLE");
-  auto value = ReadRegister(static_cast<uint8_t>(Registers::Enable));
-  value &= ~0x80;
-  WriteRegister(static_cast<uint8_t>(Registers::Enable), value);
+  enableValue &= ~0x80;
+  WriteRegister(static_cast<uint8_t>(Registers::Enable), enableValue);
 
   WriteRegister(static_cast<uint8_t>(Registers::PDriver), 0);
 }
@@ -90,17 +115,58 @@ Hrs3300::PackedHrsAls Hrs3300::ReadHrsAls() {
   // There are two extra bits (17 and 18) but they are not read here
   // as resolutions >16bit aren't practically useful (too slow) and
   // all hrs values throughout InfiniTime are 16bit
-  res.hrs = (buf[m] << 8) | ((buf[h] & 0x0f) << 4) | (buf[l] & 0x0f);
+  res.hrs = ScaleToReferenceResolution((buf[m] << 8) | ((buf[h] & 0x0f) << 4) | (buf[l] & 0x0f));
 
   // als
   m = static_cast<uint8_t>(Registers::C1dataM) - baseOffset;
   h = static_cast<uint8_t>(Registers::C1dataH) - baseOffset;
   l = static_cast<uint8_t>(Registers::C1dataL) - baseOffset;
-  res.als = ((buf[h] & 0x3f) << 11) | (buf[m] << 3) | (buf[l] & 0x07);
+  res.als = ScaleToReferenceResolution(((buf[h] & 0x3f) << 11) | (buf[m] << 3) | (buf[l] & 0x07));
 
   return res;
 }
 
+uint16_t Hrs3300::ScaleToReferenceResolution(uint32_t value) const {
+  uint8_t bits = ResolutionBits(resolution);
+  if (bits < referenceResolutionBits) {
+    // The ALS value has 17 bits: saturate instead of wrapping around
+    return std::min<uint32_t>(value << (referenceResolutionBits - bits), std::numeric_limits<uint16_t>::max());
+  }
+  return std::min<uint32_t>(value >> (bits - referenceResolutionBits), std::numeric_limits<uint16_t>::max());
+}
+
+void Hrs3300::SetProfile(Profiles profile) {
+  SetProfile(profiles[static_cast<uint8_t>(profile)]);
+}
+
+void Hrs3300::SetProfile(const Profile& profile) {
+  ledCurrent = profile.ledCurrent;
+  resolution = profile.resolution;
+
+  // HWT is bits 4-6 of the Enable register, PDRIVE[1] is bit 3, PDRIVE[0] is written to PDriver by WritePDriver()
+  enableValue = (enableValue & 0x80) | (static_cast<uint8_t>(profile.waitTime) << 4) | ((static_cast<uint8_t>(ledCurrent) & 0x02) << 2);
+  WriteRegister(static_cast<uint8_t>(Registers::Enable), enableValue);
+
+  // Res and Hgain are consecutive registers, written in a single transaction.
+  // The resolution is set for both the HRS and the ALS channels, HGAIN is bits 2-4 of the Hgain register.
+  hgainValue = (hgainValue & ~0x1c) | (static_cast<uint8_t>(profile.gain) << 2);
+  uint8_t res = static_cast<uint8_t>(profile.resolution);
+  const uint8_t values[] = {static_cast<uint8_t>((res << 4) | res), hgainValue};
+  static_assert(static_cast<uint8_t>(Registers::Hgain) == static_cast<uint8_t>(Registers::Res) + 1);
+  if (twiMaster.Write(twiAddress, static_cast<uint8_t>(Registers::Res), values, sizeof(values)) != TwiMaster::ErrorCodes::NoError) {
+    NRF_LOG_INFO("WRITE ERROR");
+  }
+
+  if ((enableValue & 0x80) != 0) {
+    WritePDriver();
+  }
+}
+
+void Hrs3300::WritePDriver() {
+  // PDRIVE[0] is bit 6 of the PDriver register
+  WriteRegister(static_cast<uint8_t>(Registers::PDriver), ledDriveCurrentValue | ((static_cast<uint8_t>(ledCurrent) & 0x01) << 6));
+}
+
 void Hrs3300::WriteRegister(uint8_t reg, uint8_t data) {
   auto ret = twiMaster.Write(twiAddress, reg, &data, 1);
   if (ret != TwiMaster::ErrorCodes::NoError)
@@ -21,6 +21,22 @@ namespace Pinetime {
         Hgain = 0x17
       };
 
+      enum class LedCurrent : uint8_t { Current12_5mA, Current20mA, Current30mA, Current40mA };
+      enum class Gain : uint8_t { Gain1x, Gain2x, Gain4x, Gain8x, Gain64x };
+      enum class WaitTime : uint8_t { Wait800ms, Wait400ms, Wait200ms, Wait100ms, Wait75ms, Wait50ms, Wait12_5ms, Wait0ms };
+      enum class Resolution : uint8_t { Resolution14Bit = 6, Resolution15Bit = 7, Resolution16Bit = 8 };
+
+      struct Profile {
+        WaitTime waitTime;
+        Resolution resolution;
+        LedCurrent ledCurrent;
+        Gain gain;
+      };
+
+      // Sensor configurations, from the least to the most power hungry.
+      // Each of them converts a sample about every 100ms (wait time + conversion time of the resolution).
+      enum class Profiles : uint8_t { Standard, Boosted, Maximum };
+
       struct PackedHrsAls {
         uint16_t hrs;
         uint16_t als;
@@ -36,10 +52,21 @@ namespace Pinetime {
       void Enable();
       void Disable();
       PackedHrsAls ReadHrsAls();
+      void SetProfile(Profiles profile);
+      void SetProfile(const Profile& profile);
 
     private:
       TwiMaster& twiMaster;
       uint8_t twiAddress;
+      LedCurrent ledCurrent = LedCurrent::Current12_5mA;
+      Resolution resolution = Resolution::Resolution15Bit;
+
+      // Last values written to the configuration registers, to avoid reading them back before each change
+      uint8_t enableValue = 0;
+      uint8_t hgainValue = 0;
+
+      uint16_t ScaleToReferenceResolution(uint32_t value) const;
+      void WritePDriver();
 
       void WriteRegister(uint8_t reg, uint8_t data);
       uint8_t ReadRegister(uint8_t reg);
@@ -17,6 +17,15 @@ bool Spi::Read(uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize) {
   return spiMaster.Read(pinCsn, cmd, cmdSize, data, dataSize);
 }
 
+bool Spi::ReadChunks(uint8_t* cmd,
+                     size_t cmdSize,
+                     uint8_t* buffer,
+                     size_t bufferSize,
+                     size_t size,
+                     const std::function<void(const uint8_t*, size_t)>& onChunk) {
+  return spiMaster.ReadChunks(pinCsn, cmd, cmdSize, buffer, bufferSize, size, onChunk);
+}
+
 void Spi::Sleep() {
   nrf_gpio_cfg_default(pinCsn);
   NRF_LOG_INFO("[SPI] Sleep")
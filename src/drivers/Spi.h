@@ -17,6 +17,12 @@ namespace Pinetime {
       bool Init();
       bool Write(const uint8_t* data, size_t size, const std::function<void()>& preTransactionHook);
       bool Read(uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize);
+      bool ReadChunks(uint8_t* cmd,
+                      size_t cmdSize,
+                      uint8_t* buffer,
+                      size_t bufferSize,
+                      size_t size,
+                      const std::function<void(const uint8_t*, size_t)>& onChunk);
       bool WriteCmdAndBuffer(const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize);
       void Sleep();
       void Wakeup();
@@ -3,6 +3,7 @@
 #include <hal/nrf_spim.h>
 #include <nrfx_log.h>
 #include <algorithm>
+#include "utility/Trace.h"
 
 using namespace Pinetime::Drivers;
 
@@ -150,6 +151,7 @@ void SpiMaster::OnEndEvent() {
     spiBaseAddress->TASKS_START = 1;
   } else {
     nrf_gpio_pin_set(this->pinCsn);
+    Utility::Trace::Record(Utility::Trace::Event::SpiEnd, pinCsn << 24);
     currentBufferAddr = 0;
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     xSemaphoreGiveFromISR(mutex, &xHigherPriorityTaskWoken);
@@ -197,6 +199,7 @@ bool SpiMaster::Write(uint8_t pinCsn, const uint8_t* data, size_t size, const st
   if (preTransactionHook != nullptr) {
     preTransactionHook();
   }
+  Utility::Trace::Record(Utility::Trace::Event::SpiStart, (pinCsn << 24) | size);
   nrf_gpio_pin_clear(this->pinCsn);
 
   currentBufferAddr = (uint32_t) data;
@@ -212,6 +215,7 @@ bool SpiMaster::Write(uint8_t pinCsn, const uint8_t* data, size_t size, const st
     while (spiBaseAddress->EVENTS_END == 0)
       ;
     nrf_gpio_pin_set(this->pinCsn);
+    Utility::Trace::Record(Utility::Trace::Event::SpiEnd, pinCsn << 24);
     currentBufferAddr = 0;
 
     DisableWorkaroundForErratum58();
@@ -223,6 +227,19 @@ bool SpiMaster::Write(uint8_t pinCsn, const uint8_t* data, size_t size, const st
 }
 
 bool SpiMaster::Read(uint8_t pinCsn, uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize) {
+  return ReadChunks(pinCsn, cmd, cmdSize, data, dataSize, dataSize, nullptr);
+}
+
+bool SpiMaster::ReadChunks(uint8_t pinCsn,
+                           uint8_t* cmd,
+                           size_t cmdSize,
+                           uint8_t* buffer,
+                           size_t bufferSize,
+                           size_t size,
+                           const std::function<void(const uint8_t*, size_t)>& onChunk) {
+  // 1 byte chunks would need a 1 byte transfer before the end of the transaction, see Receive()
+  if (size > 0 && (buffer == nullptr || bufferSize == 0 || (bufferSize == 1 && size > 1)))
+    return false;
   xSemaphoreTake(mutex, portMAX_DELAY);
 
   this->pinCsn = pinCsn;
@@ -231,6 +248,7 @@ bool SpiMaster::Read(uint8_t pinCsn, uint8_t* cmd, size_t cmdSize, uint8_t* data
   spiBaseAddress->INTENCLR = (1 << 1);
   spiBaseAddress->INTENCLR = (1 << 19);
 
+  Utility::Trace::Record(Utility::Trace::Event::SpiStart, (pinCsn << 24) | (cmdSize + size));
   nrf_gpio_pin_clear(this->pinCsn);
 
   currentBufferAddr = 0;
@@ -241,18 +259,54 @@ bool SpiMaster::Read(uint8_t pinCsn, uint8_t* cmd, size_t cmdSize, uint8_t* data
   while (spiBaseAddress->EVENTS_END == 0)
     ;
 
-  PrepareRx((uint32_t) data, dataSize);
-  spiBaseAddress->TASKS_START = 1;
+  while (size > 0) {
+    auto chunkSize = std::min(bufferSize, size);
+    Receive(buffer, chunkSize);
+    if (onChunk != nullptr) {
+      onChunk(buffer, chunkSize);
+    }
+    size -= chunkSize;
+  }
 
-  while (spiBaseAddress->EVENTS_END == 0)
-    ;
   nrf_gpio_pin_set(this->pinCsn);
+  Utility::Trace::Record(Utility::Trace::Event::SpiEnd, pinCsn << 24);
 
   xSemaphoreGive(mutex);
 
   return true;
 }
 
+// Transmits in as many DMA transfers as needed, without releasing the chip select
+void SpiMaster::Transmit(const uint8_t* data, size_t size) {
+  while (size > 0) {
+    auto transferSize = std::min(maxDmaSize, size);
+    PrepareTx((uint32_t) data, transferSize);
+    spiBaseAddress->TASKS_START = 1;
+    while (spiBaseAddress->EVENTS_END == 0)
+      ;
+    data += transferSize;
+    size -= transferSize;
+  }
+}
+
+// Receives in as many DMA transfers as needed, without releasing the chip select.
+// A 1 byte transfer clocks an additional byte out (nRF52832 erratum 58), which would be lost in the middle of a
+// transaction: the data is split so that a 1 byte transfer can only be the last one of the transaction.
+void SpiMaster::Receive(uint8_t* data, size_t size) {
+  while (size > 0) {
+    auto transferSize = std::min(maxDmaSize, size);
+    if (size - transferSize == 1) {
+      transferSize--;
+    }
+    PrepareRx((uint32_t) data, transferSize);
+    spiBaseAddress->TASKS_START = 1;
+    while (spiBaseAddress->EVENTS_END == 0)
+      ;
+    data += transferSize;
+    size -= transferSize;
+  }
+}
+
 void SpiMaster::Sleep() {
   while (spiBaseAddress->ENABLE != 0) {
     spiBaseAddress->ENABLE = (SPIM_ENABLE_ENABLE_Disabled << SPIM_ENABLE_ENABLE_Pos);
@@ -278,6 +332,7 @@ bool SpiMaster::WriteCmdAndBuffer(uint8_t pinCsn, const uint8_t* cmd, size_t cmd
   spiBaseAddress->INTENCLR = (1 << 1);
   spiBaseAddress->INTENCLR = (1 << 19);
 
+  Utility::Trace::Record(Utility::Trace::Event::SpiStart, (pinCsn << 24) | (cmdSize + dataSize));
   nrf_gpio_pin_clear(this->pinCsn);
 
   currentBufferAddr = 0;
@@ -288,12 +343,10 @@ bool SpiMaster::WriteCmdAndBuffer(uint8_t pinCsn, const uint8_t* cmd, size_t cmd
   while (spiBaseAddress->EVENTS_END == 0)
     ;
 
-  PrepareTx((uint32_t) data, dataSize);
-  spiBaseAddress->TASKS_START = 1;
+  Transmit(data, dataSize);
 
-  while (spiBaseAddress->EVENTS_END == 0)
-    ;
   nrf_gpio_pin_set(this->pinCsn);
+  Utility::Trace::Record(Utility::Trace::Event::SpiEnd, pinCsn << 24);
 
   xSemaphoreGive(mutex);
 
@@ -36,6 +36,16 @@ namespace Pinetime {
       bool Init();
       bool Write(uint8_t pinCsn, const uint8_t* data, size_t size, const std::function<void()>& preTransactionHook);
       bool Read(uint8_t pinCsn, uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize);
+      // Sends cmd then reads size bytes in a single transaction, bufferSize bytes at a time:
+      // onChunk is called for each chunk, with the chip select still asserted.
+      // bufferSize can only be 1 when a single byte is read (nRF52832 erratum 58).
+      bool ReadChunks(uint8_t pinCsn,
+                      uint8_t* cmd,
+                      size_t cmdSize,
+                      uint8_t* buffer,
+                      size_t bufferSize,
+                      size_t size,
+                      const std::function<void(const uint8_t*, size_t)>& onChunk);
 
       bool WriteCmdAndBuffer(uint8_t pinCsn, const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize);
 
@@ -50,6 +60,8 @@ namespace Pinetime {
       void DisableWorkaroundForErratum58();
       void PrepareTx(const volatile uint32_t bufferAddress, const volatile size_t size);
       void PrepareRx(const volatile uint32_t bufferAddress, const volatile size_t size);
+      void Transmit(const uint8_t* data, size_t size);
+      void Receive(uint8_t* data, size_t size);
 
       NRF_SPIM_Type* spiBaseAddress;
       uint8_t pinCsn;
@@ -62,6 +74,8 @@ namespace Pinetime {
       SemaphoreHandle_t mutex = nullptr;
       static constexpr nrf_ppi_channel_t workaroundPpi = NRF_PPI_CHANNEL0;
       bool workaroundActive = false;
+      // EasyDMA transfers at most 255 bytes on the nRF52832
+      static constexpr size_t maxDmaSize = 255;
     };
   }
 }
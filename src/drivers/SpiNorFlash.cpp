@@ -1,12 +1,33 @@
 #include "drivers/SpiNorFlash.h"
+#include <algorithm>
 #include <hal/nrf_gpio.h>
 #include <libraries/delay/nrf_delay.h>
 #include <libraries/log/nrf_log.h>
 #include "drivers/Spi.h"
+#include "utility/FlashTelemetry.h"
+#include "utility/Trace.h"
 
 using namespace Pinetime::Drivers;
 
+namespace {
+  struct Part {
+    SpiNorFlash::Identification id;
+    const char* name;
+    uint8_t maxReadFrequencyMhz; // of the read command (0x03), which has no dummy cycles
+  };
+
+  // Parts fitted to the PineTime and compatible replacements
+  constexpr Part parts[] = {
+    {{0x0B, 0x40, 0x16}, "XT25F32B", 50},
+    {{0x68, 0x40, 0x16}, "BY25Q32", 55},
+    {{0xC8, 0x40, 0x16}, "GD25Q32", 80},
+    {{0xEF, 0x40, 0x16}, "W25Q32", 50},
+    {{0xC2, 0x20, 0x16}, "MX25L32", 50},
+  };
+}
+
 SpiNorFlash::SpiNorFlash(Spi& spi) : spi {spi} {
+  mutex = xSemaphoreCreateMutex();
 }
 
 void SpiNorFlash::Init() {
@@ -15,14 +36,33 @@ void SpiNorFlash::Init() {
                device_id.manufacturer,
                device_id.type,
                device_id.density);
+  SelectReadCommand();
+}
+
+void SpiNorFlash::SelectReadCommand() {
+  readCommand = Commands::FastRead;
+  for (const auto& part : parts) {
+    if (part.id.manufacturer == device_id.manufacturer && part.id.type == device_id.type && part.id.density == device_id.density) {
+      if (part.maxReadFrequencyMhz >= busFrequencyMhz) {
+        readCommand = Commands::Read;
+      }
+      NRF_LOG_INFO("[SpiNorFlash] %s, %s read", part.name, readCommand == Commands::Read ? "plain" : "fast");
+      return;
+    }
+  }
+  NRF_LOG_WARNING("[SpiNorFlash] Unknown part, fast read");
 }
 
 void SpiNorFlash::Uninit() {
 }
 
 void SpiNorFlash::Sleep() {
+  Lock();
+  ProgramPending();
+  WaitReady();
   auto cmd = static_cast<uint8_t>(Commands::DeepPowerDown);
   spi.Write(&cmd, sizeof(uint8_t), nullptr);
+  Unlock();
   NRF_LOG_INFO("[SpiNorFlash] Sleep")
 }
 
@@ -70,13 +110,44 @@ uint8_t SpiNorFlash::ReadConfigurationRegister() {
   return status;
 }
 
+size_t SpiNorFlash::ReadCommand(uint32_t address, uint8_t* cmd) const {
+  cmd[0] = static_cast<uint8_t>(readCommand);
+  cmd[1] = static_cast<uint8_t>(address >> 16U);
+  cmd[2] = static_cast<uint8_t>(address >> 8U);
+  cmd[3] = static_cast<uint8_t>(address);
+  if (readCommand == Commands::FastRead) {
+    cmd[4] = 0; // 8 dummy cycles
+    return 5;
+  }
+  return 4;
+}
+
 void SpiNorFlash::Read(uint32_t address, uint8_t* buffer, size_t size) {
-  static constexpr uint8_t cmdSize = 4;
-  uint8_t cmd[cmdSize] = {static_cast<uint8_t>(Commands::Read),
-                          static_cast<uint8_t>(address >> 16U),
-                          static_cast<uint8_t>(address >> 8U),
-                          static_cast<uint8_t>(address)};
-  spi.Read(reinterpret_cast<uint8_t*>(&cmd), cmdSize, buffer, size);
+  Lock();
+  ProgramPendingIfOverlapping(address, size);
+  WaitReady();
+  uint8_t cmd[maxReadCommandSize];
+  auto cmdSize = ReadCommand(address, cmd);
+  uint32_t start = Utility::FlashTelemetry::Start();
+  spi.Read(cmd, cmdSize, buffer, size);
+  Utility::FlashTelemetry::Record(Utility::FlashTelemetry::Operation::FlashRead, start, size);
+  Unlock();
+}
+
+void SpiNorFlash::ReadChunks(uint32_t address,
+                             size_t size,
+                             uint8_t* buffer,
+                             size_t bufferSize,
+                             const std::function<void(const uint8_t* data, size_t size)>& onChunk) {
+  Lock();
+  ProgramPendingIfOverlapping(address, size);
+  WaitReady();
+  uint8_t cmd[maxReadCommandSize];
+  auto cmdSize = ReadCommand(address, cmd);
+  uint32_t start = Utility::FlashTelemetry::Start();
+  spi.ReadChunks(cmd, cmdSize, buffer, bufferSize, size, onChunk);
+  Utility::FlashTelemetry::Record(Utility::FlashTelemetry::Operation::FlashRead, start, size);
+  Unlock();
 }
 
 void SpiNorFlash::WriteEnable() {
@@ -91,14 +162,22 @@ void SpiNorFlash::SectorErase(uint32_t sectorAddress) {
                           static_cast<uint8_t>(sectorAddress >> 8U),
                           static_cast<uint8_t>(sectorAddress)};
 
+  Lock();
+  ProgramPendingIfOverlapping(sectorAddress, sectorSize);
+  WaitReady();
+  Utility::Trace::Record(Utility::Trace::Event::FlashEraseStart, sectorAddress);
   WriteEnable();
   while (!WriteEnabled())
     vTaskDelay(1);
 
+  operationStart = Utility::FlashTelemetry::Start();
+  operationSize = 0;
   spi.Read(reinterpret_cast<uint8_t*>(&cmd), cmdSize, nullptr, 0);
+  operation = Operation::Erase;
 
-  while (WriteInProgress())
-    vTaskDelay(1);
+  WaitReady();
+  Utility::Trace::Record(Utility::Trace::Event::FlashEraseEnd);
+  Unlock();
 }
 
 uint8_t SpiNorFlash::ReadSecurityRegister() {
@@ -117,33 +196,113 @@ bool SpiNorFlash::EraseFailed() {
 }
 
 void SpiNorFlash::Write(uint32_t address, const uint8_t* buffer, size_t size) {
-  static constexpr uint8_t cmdSize = 4;
+  Program(address, buffer, size);
+  Sync();
+}
 
-  size_t len = size;
-  uint32_t addr = address;
-  const uint8_t* b = buffer;
-  while (len > 0) {
-    uint32_t pageLimit = (addr & ~(pageSize - 1u)) + pageSize;
-    uint32_t toWrite = pageLimit - addr > len ? len : pageLimit - addr;
+void SpiNorFlash::Program(uint32_t address, const uint8_t* buffer, size_t size) {
+  Lock();
+  while (size > 0) {
+    uint32_t page = address & ~(pageSize - 1u);
+    uint16_t offset = address - page;
+    uint16_t toWrite = std::min<size_t>(pageSize - offset, size);
 
-    uint8_t cmd[cmdSize] = {static_cast<uint8_t>(Commands::PageProgram),
-                            static_cast<uint8_t>(addr >> 16U),
-                            static_cast<uint8_t>(addr >> 8U),
-                            static_cast<uint8_t>(addr)};
+    if (pendingStart != pendingEnd && page != pendingPage) {
+      ProgramPending();
+    }
+    if (pendingStart == pendingEnd) {
+      pending.fill(0xFF);
+      pendingPage = page;
+      pendingStart = offset;
+      pendingEnd = offset;
+    }
+    // A program only clears bits: the bytes in the gaps between the writes are left unchanged
+    for (uint16_t i = 0; i < toWrite; i++) {
+      pending[offset + i] &= buffer[i];
+    }
+    pendingStart = std::min(pendingStart, offset);
+    pendingEnd = std::max<uint16_t>(pendingEnd, offset + toWrite);
+    if (pendingEnd == pageSize) {
+      ProgramPending();
+    }
 
-    WriteEnable();
-    while (!WriteEnabled())
-      vTaskDelay(1);
+    address += toWrite;
+    buffer += toWrite;
+    size -= toWrite;
+  }
+  Unlock();
+}
+
+bool SpiNorFlash::Sync() {
+  Lock();
+  ProgramPending();
+  WaitReady();
+  bool failed = programFailed;
+  programFailed = false;
+  Unlock();
+  return !failed;
+}
 
-    spi.WriteCmdAndBuffer(cmd, cmdSize, b, toWrite);
+// Starts the program of the queued writes, without waiting for its end
+void SpiNorFlash::ProgramPending() {
+  if (pendingStart == pendingEnd) {
+    return;
+  }
+  static constexpr uint8_t cmdSize = 4;
+  uint32_t address = pendingPage + pendingStart;
+  uint8_t cmd[cmdSize] = {static_cast<uint8_t>(Commands::PageProgram),
+                          static_cast<uint8_t>(address >> 16U),
+                          static_cast<uint8_t>(address >> 8U),
+                          static_cast<uint8_t>(address)};
 
-    while (WriteInProgress())
-      vTaskDelay(1);
+  WaitReady();
+  WriteEnable();
+  while (!WriteEnabled())
+    vTaskDelay(1);
+
+  operationStart = Utility::FlashTelemetry::Start();
+  operationSize = pendingEnd - pendingStart;
+  spi.WriteCmdAndBuffer(cmd, cmdSize, pending.data() + pendingStart, operationSize);
+  operation = Operation::Program;
+  pendingStart = pendingEnd = 0;
+}
+
+void SpiNorFlash::ProgramPendingIfOverlapping(uint32_t address, size_t size) {
+  if (pendingStart != pendingEnd && address < pendingPage + pageSize && pendingPage < address + size) {
+    ProgramPending();
+  }
+}
 
-    addr += toWrite;
-    b += toWrite;
-    len -= toWrite;
+void SpiNorFlash::WaitReady() {
+  if (operation == Operation::None) {
+    return;
+  }
+  uint32_t delayUs = pollFirstDelayUs;
+  while (WriteInProgress()) {
+    // Sector erases take tens of ms, there is no point in busy waiting for them
+    if (operation == Operation::Program && delayUs <= pollMaxDelayUs) {
+      nrf_delay_us(delayUs);
+      delayUs *= 2;
+    } else {
+      vTaskDelay(1);
+    }
   }
+  Utility::FlashTelemetry::Record(
+    operation == Operation::Program ? Utility::FlashTelemetry::Operation::FlashProgram : Utility::FlashTelemetry::Operation::FlashErase,
+    operationStart,
+    operationSize);
+  if (operation == Operation::Program && ProgramFailed()) {
+    programFailed = true;
+  }
+  operation = Operation::None;
+}
+
+void SpiNorFlash::Lock() {
+  xSemaphoreTake(mutex, portMAX_DELAY);
+}
+
+void SpiNorFlash::Unlock() {
+  xSemaphoreGive(mutex);
 }
 
 SpiNorFlash::Identification SpiNorFlash::GetIdentification() const {
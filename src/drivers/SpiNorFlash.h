@@ -1,6 +1,10 @@
 #pragma once
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <FreeRTOS.h>
+#include <semphr.h>
 
 namespace Pinetime {
   namespace Drivers {
@@ -25,7 +29,19 @@ namespace Pinetime {
       bool WriteEnabled();
       uint8_t ReadConfigurationRegister();
       void Read(uint32_t address, uint8_t* buffer, size_t size);
+      // Reads size bytes in a single transaction, through a buffer of bufferSize bytes passed to onChunk when it is full
+      void ReadChunks(uint32_t address,
+                      size_t size,
+                      uint8_t* buffer,
+                      size_t bufferSize,
+                      const std::function<void(const uint8_t* data, size_t size)>& onChunk);
+      // Programs and waits for the end of the programs
       void Write(uint32_t address, const uint8_t* buffer, size_t size);
+      // Queues a write, and returns while the last page is being programmed. The writes to a page are coalesced into
+      // a single page program, sent when another page is written, when the end of the page is reached or by Sync().
+      void Program(uint32_t address, const uint8_t* buffer, size_t size);
+      // Programs the queued writes and waits for the end of the programs, returns false if one of them failed
+      bool Sync();
       void WriteEnable();
       void SectorErase(uint32_t sectorAddress);
       uint8_t ReadSecurityRegister();
@@ -42,10 +58,18 @@ namespace Pinetime {
 
     private:
       Identification ReadIdentification();
+      void SelectReadCommand();
+      size_t ReadCommand(uint32_t address, uint8_t* cmd) const;
+      void Lock();
+      void Unlock();
+      void ProgramPending();
+      void ProgramPendingIfOverlapping(uint32_t address, size_t size);
+      void WaitReady();
 
       enum class Commands : uint8_t {
         PageProgram = 0x02,
         Read = 0x03,
+        FastRead = 0x0B,
         ReadStatusRegister = 0x05,
         WriteEnable = 0x06,
         ReadConfigurationRegister = 0x15,
@@ -56,9 +80,33 @@ namespace Pinetime {
         DeepPowerDown = 0xB9
       };
       static constexpr uint16_t pageSize = 256;
+      static constexpr uint32_t sectorSize = 4096;
+      static constexpr size_t maxReadCommandSize = 5;
+      // Clock of the SPI bus, the maximum of the nRF52832
+      static constexpr uint8_t busFrequencyMhz = 8;
+
+      // Page programs take about 0.5ms: the status register is polled after a short busy wait, doubled at each poll,
+      // before falling back to waiting for the next tick
+      static constexpr uint32_t pollFirstDelayUs = 50;
+      static constexpr uint32_t pollMaxDelayUs = 400;
+
+      enum class Operation : uint8_t { None, Program, Erase };
 
       Spi& spi;
       Identification device_id;
+      SemaphoreHandle_t mutex;
+      Operation operation = Operation::None; // started and maybe not finished yet
+      uint32_t operationStart = 0;            // FlashTelemetry::Start() when the operation was started
+      uint16_t operationSize = 0;
+      bool programFailed = false;
+
+      // Coalesced writes to a page, not programmed yet
+      std::array<uint8_t, pageSize> pending;
+      uint32_t pendingPage = 0;
+      uint16_t pendingStart = 0;
+      uint16_t pendingEnd = 0; // empty when pendingStart == pendingEnd
+      // Fast read works at any frequency, Init() selects the plain read when the part supports the bus frequency
+      Commands readCommand = Commands::FastRead;
     };
   }
 }
@@ -2,6 +2,7 @@
 #include <cstring>
 #include <hal/nrf_gpio.h>
 #include <nrfx_log.h>
+#include "utility/Trace.h"
 
 using namespace Pinetime::Drivers;
 
@@ -50,10 +51,12 @@ void TwiMaster::Init() {
 
 TwiMaster::ErrorCodes TwiMaster::Read(uint8_t deviceAddress, uint8_t registerAddress, uint8_t* data, size_t size) {
   xSemaphoreTake(mutex, portMAX_DELAY);
+  Utility::Trace::Record(Utility::Trace::Event::TwiStart, (deviceAddress << 8) | registerAddress);
   Wakeup();
   auto ret = Write(deviceAddress, &registerAddress, 1, false);
   ret = Read(deviceAddress, data, size, true);
   Sleep();
+  Utility::Trace::Record(Utility::Trace::Event::TwiEnd, static_cast<uint32_t>(ret));
   xSemaphoreGive(mutex);
   return ret;
 }
@@ -61,11 +64,13 @@ TwiMaster::ErrorCodes TwiMaster::Read(uint8_t deviceAddress, uint8_t registerAdd
 TwiMaster::ErrorCodes TwiMaster::Write(uint8_t deviceAddress, uint8_t registerAddress, const uint8_t* data, size_t size) {
   ASSERT(size <= maxDataSize);
   xSemaphoreTake(mutex, portMAX_DELAY);
+  Utility::Trace::Record(Utility::Trace::Event::TwiStart, (1 << 16) | (deviceAddress << 8) | registerAddress);
   Wakeup();
   internalBuffer[0] = registerAddress;
   std::memcpy(internalBuffer + 1, data, size);
   auto ret = Write(deviceAddress, internalBuffer, size + 1, true);
   Sleep();
+  Utility::Trace::Record(Utility::Trace::Event::TwiEnd, static_cast<uint32_t>(ret));
   xSemaphoreGive(mutex);
   return ret;
 }
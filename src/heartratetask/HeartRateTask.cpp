@@ -1,7 +1,11 @@
 #include "heartratetask/HeartRateTask.h"
 #include <drivers/Hrs3300.h>
 #include <components/heartrate/HeartRateController.h>
+#include <components/heartrate/HeartRateHistory.h>
+#include <components/motion/MotionController.h>
+#include <algorithm>
 #include <limits>
+#include "utility/Math.h"
 
 using namespace Pinetime::Applications;
 
@@ -13,6 +17,14 @@ namespace {
   constexpr T RoundedDiv(T dividend, T divisor) {
     return (dividend + (divisor / static_cast<T>(2))) / divisor;
   }
+
+  uint32_t TicksToMilliseconds(TickType_t ticks) {
+    return static_cast<uint32_t>(static_cast<uint64_t>(ticks) * 1000 / configTICK_RATE_HZ);
+  }
+
+  uint16_t AccelerationMagnitude(int16_t x, int16_t y, int16_t z) {
+    return Pinetime::Utility::Sqrt(static_cast<uint32_t>(x * x) + static_cast<uint32_t>(y * y) + static_cast<uint32_t>(z * z));
+  }
 }
 
 std::optional<TickType_t> HeartRateTask::BackgroundMeasurementInterval() const {
@@ -20,7 +32,9 @@ std::optional<TickType_t> HeartRateTask::BackgroundMeasurementInterval() const {
   if (!interval.has_value()) {
     return std::nullopt;
   }
-  return interval.value() * configTICK_RATE_HZ;
+  TickType_t baseInterval = interval.value() * configTICK_RATE_HZ;
+  // Shortened intervals never go below the measurement time limit, so that measurements don't overlap
+  return std::max(scheduler.NextInterval(baseInterval), std::min(baseInterval, backgroundMeasurementTimeLimit));
 }
 
 bool HeartRateTask::BackgroundMeasurementNeeded() const {
@@ -90,17 +104,25 @@ TickType_t HeartRateTask::CurrentTaskDelay() {
 
 HeartRateTask::HeartRateTask(Drivers::Hrs3300& heartRateSensor,
                              Controllers::HeartRateController& controller,
+                             Controllers::MotionController& motionController,
+                             Controllers::HeartRateHistory& history,
+                             Controllers::FS& fs,
                              Controllers::Settings& settings)
-  : heartRateSensor {heartRateSensor}, controller {controller}, settings {settings} {
+  : heartRateSensor {heartRateSensor},
+    controller {controller},
+    motionController {motionController},
+    history {history},
+    settings {settings},
+    capture {fs} {
 }
 
 void HeartRateTask::Start() {
-  messageQueue = xQueueCreate(10, 1);
-  controller.SetHeartRateTask(this);
-
-  if (pdPASS != xTaskCreate(HeartRateTask::Process, "Heartrate", 500, this, 1, &taskHandle)) {
+  // The stack also accommodates the littlefs calls made while capturing raw PPG data and logging the history
+  // (lfs_info alone holds a 256 byte name)
+  if (pdPASS != xTaskCreate(HeartRateTask::Process, "Heartrate", 800, this, 1, &taskHandle)) {
     APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
   }
+  controller.SetHeartRateTask(this);
 }
 
 void HeartRateTask::Process(void* instance) {
@@ -113,17 +135,29 @@ void HeartRateTask::Work() {
   // Need to initialise lastMeasurementTime so that the first background measurement happens at a reasonable time
   lastMeasurementTime = xTaskGetTickCount();
   valueCurrentlyShown = false;
+  capture.CheckArmed();
 
   while (true) {
     TickType_t delay = CurrentTaskDelay();
-    Messages msg;
+    uint32_t events = 0;
     States newState = state;
 
-    if (xQueueReceive(messageQueue, &msg, delay) == pdTRUE) {
-      switch (msg) {
+    // Enable/Disable are handled first: the screen is always on when the measurement is enabled
+    Messages messages[2];
+    uint8_t nbMessages = 0;
+    if (xTaskNotifyWait(0, UINT32_MAX, &events, delay) == pdTRUE) {
+      if ((events & enableEvent) != 0) {
+        messages[nbMessages++] = enabled ? Messages::Enable : Messages::Disable;
+      }
+      if ((events & powerEvent) != 0) {
+        messages[nbMessages++] = awake ? Messages::WakeUp : Messages::GoToSleep;
+      }
+    }
+    for (uint8_t i = 0; i < nbMessages; i++) {
+      switch (messages[i]) {
         case Messages::GoToSleep:
           // Ignore power state changes when disabled
-          if (state == States::Disabled) {
+          if (newState == States::Disabled) {
             break;
           }
           // State is necessarily ForegroundMeasuring
@@ -135,8 +169,10 @@ void HeartRateTask::Work() {
           }
           break;
         case Messages::WakeUp:
+          // Picks up a capture file created over BLE since the last check
+          capture.CheckArmed();
           // Ignore power state changes when disabled
-          if (state == States::Disabled) {
+          if (newState == States::Disabled) {
             break;
           }
           newState = States::ForegroundMeasuring;
@@ -162,7 +198,16 @@ void HeartRateTask::Work() {
     // Apply state transition (switch sensor on/off)
     if ((newState == States::ForegroundMeasuring || newState == States::BackgroundMeasuring) &&
         (state == States::Waiting || state == States::Disabled)) {
+      // Screen on measurements always use the standard sensor configuration
+      if (newState == States::BackgroundMeasuring) {
+        ApplyDriveLevel(scheduler.DriveLevel());
+      } else {
+        heartRateSensor.SetProfile(Drivers::Hrs3300::Profiles::Standard);
+      }
       StartMeasurement();
+    } else if (newState == States::BackgroundMeasuring && state == States::ForegroundMeasuring) {
+      // The screen turned off during a measurement, which now has to stabilise as a background one
+      scheduler.StartMeasurement();
     } else if ((newState == States::Waiting || newState == States::Disabled) &&
                (state == States::ForegroundMeasuring || state == States::BackgroundMeasuring)) {
       StopMeasurement();
@@ -177,29 +222,65 @@ void HeartRateTask::Work() {
 }
 
 void HeartRateTask::PushMessage(HeartRateTask::Messages msg) {
+  uint32_t event;
+  switch (msg) {
+    case Messages::GoToSleep:
+    case Messages::WakeUp:
+      awake = msg == Messages::WakeUp;
+      event = powerEvent;
+      break;
+    default:
+      enabled = msg == Messages::Enable;
+      event = enableEvent;
+      break;
+  }
   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-  xQueueSendFromISR(messageQueue, &msg, &xHigherPriorityTaskWoken);
+  xTaskNotifyFromISR(taskHandle, event, eSetBits, &xHigherPriorityTaskWoken);
   portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
 void HeartRateTask::StartMeasurement() {
   heartRateSensor.Enable();
   ppg.Reset(true);
+  scheduler.StartMeasurement();
   vTaskDelay(100);
   measurementSucceeded = false;
   count = 0;
   measurementStartTime = xTaskGetTickCount();
+  capture.Start(TicksToMilliseconds(measurementStartTime), Controllers::Ppg::deltaTms);
 }
 
 void HeartRateTask::StopMeasurement() {
+  capture.Stop();
   heartRateSensor.Disable();
   ppg.Reset(true);
   vTaskDelay(100);
 }
 
+void HeartRateTask::ApplyDriveLevel(Controllers::HeartRateScheduler::DriveLevels level) {
+  using DriveLevels = Controllers::HeartRateScheduler::DriveLevels;
+  switch (level) {
+    case DriveLevels::Baseline:
+      heartRateSensor.SetProfile(Drivers::Hrs3300::Profiles::Standard);
+      break;
+    case DriveLevels::Boosted:
+      heartRateSensor.SetProfile(Drivers::Hrs3300::Profiles::Boosted);
+      break;
+    case DriveLevels::Maximum:
+      heartRateSensor.SetProfile(Drivers::Hrs3300::Profiles::Maximum);
+      break;
+  }
+}
+
 void HeartRateTask::HandleSensorData() {
   auto sensorData = heartRateSensor.ReadHrsAls();
-  int8_t ambient = ppg.Preprocess(sensorData.hrs, sensorData.als);
+  // The latest accelerometer sample is used as the motion reference for artifact rejection
+  int16_t x = motionController.X();
+  int16_t y = motionController.Y();
+  int16_t z = motionController.Z();
+  capture.AddSample(TicksToMilliseconds(xTaskGetTickCount()), sensorData.hrs, sensorData.als, x, y, z);
+  uint16_t motion = AccelerationMagnitude(x, y, z);
+  int8_t ambient = ppg.Preprocess(sensorData.hrs, sensorData.als, motion);
   int bpm = ppg.HeartRate();
 
   // Ambient light detected
@@ -228,6 +309,23 @@ void HeartRateTask::HandleSensorData() {
   }
 
   if (bpm != 0) {
+    measurementSucceeded = true;
+    valueCurrentlyShown = true;
+    controller.Update(Controllers::HeartRateController::States::Running, bpm);
+
+    // Background measurements keep going until the estimate is stable (or the time limit is reached)
+    if (state == States::BackgroundMeasuring) {
+      if (!scheduler.OnEstimate(bpm, ppg.Confidence(), ppg.MotionDetected())) {
+        bpm = 0;
+      } else {
+        scheduler.OnMeasurementDone(true);
+      }
+    }
+  }
+
+  if (bpm != 0) {
+    history.Append(bpm);
+
     // Maintain constant frequency acquisition in background mode
     // If the last measurement time is set to the start time, then the next measurement
     // will start exactly one background period after this one
@@ -237,9 +335,6 @@ void HeartRateTask::HandleSensorData() {
     } else {
       lastMeasurementTime = xTaskGetTickCount();
     }
-    measurementSucceeded = true;
-    valueCurrentlyShown = true;
-    controller.Update(Controllers::HeartRateController::States::Running, bpm);
     return;
   }
   // If been measuring for longer than the time limit, set the last measurement time
@@ -257,6 +352,8 @@ void HeartRateTask::HandleSensorData() {
       valueCurrentlyShown = false;
     }
     if (state == States::BackgroundMeasuring) {
+      // A value that never stabilised still counts as a failure for the drive level
+      scheduler.OnMeasurementDone(false);
       lastMeasurementTime = xTaskGetTickCount() - backgroundMeasurementTimeLimit;
     } else {
       lastMeasurementTime = xTaskGetTickCount();
@@ -3,8 +3,10 @@
 #include <cstdint>
 #include <optional>
 #include <task.h>
-#include <queue.h>
+#include <atomic>
 #include <components/heartrate/Ppg.h>
+#include <components/heartrate/HeartRateScheduler.h>
+#include <components/heartrate/PpgCapture.h>
 #include "components/settings/Settings.h"
 
 namespace Pinetime {
@@ -14,6 +16,9 @@ namespace Pinetime {
 
   namespace Controllers {
     class HeartRateController;
+    class MotionController;
+    class HeartRateHistory;
+    class FS;
   }
 
   namespace Applications {
@@ -23,6 +28,9 @@ namespace Pinetime {
 
       explicit HeartRateTask(Drivers::Hrs3300& heartRateSensor,
                              Controllers::HeartRateController& controller,
+                             Controllers::MotionController& motionController,
+                             Controllers::HeartRateHistory& history,
+                             Controllers::FS& fs,
                              Controllers::Settings& settings);
       void Start();
       void Work();
@@ -34,21 +42,31 @@ namespace Pinetime {
       void HandleSensorData();
       void StartMeasurement();
       void StopMeasurement();
+      void ApplyDriveLevel(Controllers::HeartRateScheduler::DriveLevels level);
 
       [[nodiscard]] bool BackgroundMeasurementNeeded() const;
       [[nodiscard]] std::optional<TickType_t> BackgroundMeasurementInterval() const;
       TickType_t CurrentTaskDelay();
 
-      TaskHandle_t taskHandle;
-      QueueHandle_t messageQueue;
+      // Messages are sent as notification bits: only the last of GoToSleep/WakeUp and of Enable/Disable matters
+      static constexpr uint32_t powerEvent = 1 << 0;
+      static constexpr uint32_t enableEvent = 1 << 1;
+
+      TaskHandle_t taskHandle = nullptr;
+      std::atomic_bool awake {true};
+      std::atomic_bool enabled {false};
       bool valueCurrentlyShown;
       bool measurementSucceeded;
       States state = States::Disabled;
       uint16_t count;
       Drivers::Hrs3300& heartRateSensor;
       Controllers::HeartRateController& controller;
+      Controllers::MotionController& motionController;
+      Controllers::HeartRateHistory& history;
       Controllers::Settings& settings;
       Controllers::Ppg ppg;
+      Controllers::HeartRateScheduler scheduler;
+      Controllers::PpgCapture capture;
       TickType_t lastMeasurementTime;
       TickType_t measurementStartTime;
     };
@@ -36,6 +36,9 @@
 #include "components/motor/MotorController.h"
 #include "components/datetime/DateTimeController.h"
 #include "components/heartrate/HeartRateController.h"
+#include "components/heartrate/HeartRateHistory.h"
+#include "components/motion/ActivityHistory.h"
+#include "components/motion/SleepTracker.h"
 #include "components/stopwatch/StopWatchController.h"
 #include "components/fs/FS.h"
 #include "drivers/Spi.h"
@@ -100,12 +103,14 @@ Pinetime::Controllers::Settings settingsController {fs};
 Pinetime::Controllers::MotorController motorController {};
 
 Pinetime::Controllers::HeartRateController heartRateController;
-Pinetime::Applications::HeartRateTask heartRateApp(heartRateSensor, heartRateController, settingsController);
+Pinetime::Controllers::MotionController motionController;
 
 Pinetime::Controllers::DateTime dateTimeController {settingsController};
+Pinetime::Controllers::HeartRateHistory heartRateHistory {fs, dateTimeController};
+Pinetime::Applications::HeartRateTask
+  heartRateApp(heartRateSensor, heartRateController, motionController, heartRateHistory, fs, settingsController);
 Pinetime::Drivers::Watchdog watchdog;
 Pinetime::Controllers::NotificationManager notificationManager;
-Pinetime::Controllers::MotionController motionController;
 Pinetime::Controllers::StopWatchController stopWatchController;
 Pinetime::Controllers::AlarmController alarmController {dateTimeController, fs};
 Pinetime::Controllers::TouchHandler touchHandler;
@@ -131,6 +136,10 @@ Pinetime::Applications::DisplayApp displayApp(lcd,
                                               fs,
                                               spiNorFlash);
 
+// Keeps 4 weeks of daily totals
+Pinetime::Controllers::ActivityHistory activityHistory {fs, dateTimeController, motionController, 4};
+Pinetime::Controllers::SleepTracker sleepTracker {fs, dateTimeController, motionController};
+
 Pinetime::System::SystemTask systemTask(spi,
                                         spiNorFlash,
                                         twiMaster,
@@ -145,6 +154,8 @@ Pinetime::System::SystemTask systemTask(spi,
                                         heartRateSensor,
                                         motionController,
                                         motionSensor,
+                                        activityHistory,
+                                        sleepTracker,
                                         settingsController,
                                         heartRateController,
                                         displayApp,
@@ -178,6 +189,11 @@ void nrfx_gpiote_evt_handler(nrfx_gpiote_pin_t pin, nrf_gpiote_polarity_t action
     return;
   }
 
+  if (pin == Pinetime::PinMap::Bma421Irq) {
+    systemTask.PushMessage(Pinetime::System::Messages::OnMotionInterrupt);
+    return;
+  }
+
   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
   if (pin == Pinetime::PinMap::PowerPresent and action == NRF_GPIOTE_POLARITY_TOGGLE) {
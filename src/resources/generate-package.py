@@ -6,15 +6,63 @@ import json
 import shutil
 import typing
 import os.path
+import struct
 import argparse
 import subprocess
 from zipfile import ZipFile
 
+PACK_PATH = '/resources.pak'
+PACK_ALIGNMENT = 16
+
+def fnv1a(path):
+    h = 2166136261
+    for byte in path.encode():
+        h = ((h ^ byte) * 16777619) & 0xffffffff
+    return h
+
+# Resource pack read by src/components/fs/ResourcePack.cpp: a header, an index sorted by the hash of the paths,
+# the paths, checked by the watch when the hash matches, and the resources
+def write_pack(resources, output):
+    entries = []
+    for path, filename in resources:
+        with open(filename, 'rb') as fd:
+            entries.append((fnv1a(path), path, fd.read()))
+    entries.sort()
+    for previous, entry in zip(entries, entries[1:]):
+        if previous[0] == entry[0]:
+            sys.exit(f'Error: {previous[1]} and {entry[1]} have the same hash, rename one of them.')
+
+    header_size = 16
+    entry_size = 16
+    paths = b''
+    path_offsets = []
+    for h, path, content in entries:
+        path_offsets.append(header_size + entry_size * len(entries) + len(paths))
+        paths += path.encode() + b'\0'
+
+    offset = header_size + entry_size * len(entries) + len(paths)
+    index = b''
+    data = b''
+    for (h, path, content), path_offset in zip(entries, path_offsets):
+        padding = -offset % PACK_ALIGNMENT
+        data += b'\0' * padding
+        offset += padding
+        index += struct.pack('<IIII', h, offset, len(content), path_offset)
+        data += content
+        offset += len(content)
+
+    with open(output, 'wb') as fd:
+        fd.write(struct.pack('<4sHH8x', b'RPAK', 1, len(entries)))
+        fd.write(index)
+        fd.write(paths)
+        fd.write(data)
+
 def main():
     ap = argparse.ArgumentParser(description='auto generate LVGL font files from fonts')
     ap.add_argument('--config', '-c', type=str, action='append', help='config file to use')
     ap.add_argument('--obsolete', type=str, help='List of obsolete files')
     ap.add_argument('--output', type=str, help='output file name')
+    ap.add_argument('--pack', action='store_true', help='package the resources in a single resource pack')
     args = ap.parse_args()
 
     for config_file in args.config:
@@ -32,6 +80,7 @@ def main():
 
     zf = ZipFile(args.output, mode='w')
     resource_files = []
+    packed_files = []
 
     for config_file in args.config:
         with open(config_file, 'r') as fd:
@@ -40,16 +89,27 @@ def main():
         resource_names = set(data.keys())
         for name in resource_names:
             resource = data[name]
+            path = name + '.bin'
+            if not os.path.exists(path):
+                path = os.path.join(os.path.dirname(sys.argv[0]), path)
+
+            if args.pack:
+                packed_files.append((resource['target_path'] + name + '.bin', path))
+                continue
             resource_files.append({
                 "filename": name+'.bin',
                 "path": resource['target_path'] + name+'.bin'
             })
-
-            path = name + '.bin'
-            if not os.path.exists(path):
-                path = os.path.join(os.path.dirname(sys.argv[0]), path)
             zf.write(path)
 
+    if args.pack:
+        write_pack(packed_files, 'resources.pak')
+        resource_files.append({
+            "filename": 'resources.pak',
+            "path": PACK_PATH
+        })
+        zf.write('resources.pak')
+
     if args.obsolete:
         obsolete_file_path = os.path.join(os.path.dirname(sys.argv[0]), args.obsolete)
         with open(obsolete_file_path, 'r') as fd:
@@ -29,7 +29,13 @@ namespace Pinetime {
       BatteryPercentageUpdated,
       StartFileTransfer,
       StopFileTransfer,
-      BleRadioEnableToggle
+      BleRadioEnableToggle,
+      OnMotionInterrupt,
+      OnActivityMinute,
+      OnSleepEpoch,
+      OnHousekeepingTimer,
+      OnMotionPollTimer,
+      OnBleDiscoveryTimer
     };
   }
 }
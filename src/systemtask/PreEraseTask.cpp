@@ -0,0 +1,41 @@
+#include "systemtask/PreEraseTask.h"
+#include <libraries/log/nrf_log.h>
+#include "components/fs/FS.h"
+
+using namespace Pinetime::System;
+
+PreEraseTask::PreEraseTask(Controllers::FS& fs) : fs {fs} {
+}
+
+void PreEraseTask::Start() {
+  // The stack holds the traversal of littlefs and the flash erase
+  if (pdPASS != xTaskCreate(PreEraseTask::Process, "ERASE", 256, this, 0, &taskHandle)) {
+    APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
+  }
+}
+
+void PreEraseTask::Process(void* instance) {
+  auto* app = static_cast<PreEraseTask*>(instance);
+  NRF_LOG_INFO("pre-erase task started!");
+  app->Work();
+}
+
+void PreEraseTask::Run() {
+  running = true;
+  xTaskNotifyGive(taskHandle);
+}
+
+void PreEraseTask::Stop() {
+  running = false;
+}
+
+void PreEraseTask::Work() {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    // The flash is powered down while the watch sleeps: keep it up for the whole sequence of erases
+    fs.HoldFlash();
+    while (running && fs.PreErase()) {
+    }
+    fs.ReleaseFlash();
+  }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <FreeRTOS.h>
+#include <task.h>
+
+namespace Pinetime {
+  namespace Controllers {
+    class FS;
+  }
+
+  namespace System {
+    // Erases the free blocks of the file system ahead of time (see FS::PreErase()) while the watch sleeps.
+    // It runs at the lowest priority, so that the erases only use the time no other task needs.
+    class PreEraseTask {
+    public:
+      explicit PreEraseTask(Controllers::FS& fs);
+      PreEraseTask(const PreEraseTask&) = delete;
+      PreEraseTask& operator=(const PreEraseTask&) = delete;
+      PreEraseTask(PreEraseTask&&) = delete;
+      PreEraseTask& operator=(PreEraseTask&&) = delete;
+
+      void Start();
+      // Erases until enough blocks are erased or Stop() is called
+      void Run();
+      // Returns at once: the erase in progress, if any, holds the file system until it completes (about 50ms)
+      void Stop();
+
+    private:
+      static void Process(void* instance);
+      void Work();
+
+      Controllers::FS& fs;
+      TaskHandle_t taskHandle = nullptr;
+      std::atomic_bool running {false};
+    };
+  }
+}
@@ -0,0 +1,50 @@
+#include "systemtask/RunTimeStats.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace Pinetime::System;
+
+void RunTimeStats::Update() {
+  auto nb = uxTaskGetSystemState(status.data(), status.size(), nullptr);
+  TickType_t now = xTaskGetTickCount();
+  // The run time counter is in us
+  uint64_t periodUs = static_cast<uint64_t>(now - lastUpdate) * 1000000 / configTICK_RATE_HZ;
+  lastUpdate = now;
+  TaskHandle_t idleTask = xTaskGetIdleTaskHandle();
+
+  snapshot = {};
+  snapshot.period = periodUs / 1000;
+  uint32_t busy = 0;
+  for (UBaseType_t i = 0; i < nb; i++) {
+    auto number = status[i].xTaskNumber;
+    if (number >= previous.size()) {
+      continue;
+    }
+    uint32_t runTime = status[i].ulRunTimeCounter - previous[number].runTime;
+    uint32_t switches = RunTimeStatsSwitchCount(number) - previous[number].switches;
+    previous[number] = {status[i].ulRunTimeCounter, RunTimeStatsSwitchCount(number)};
+
+    auto& task = snapshot.tasks[snapshot.nbTasks++];
+    std::strncpy(task.name, status[i].pcTaskName, sizeof(task.name) - 1);
+    task.load = periodUs > 0 ? std::min<uint64_t>(runTime * 1000ULL / periodUs, 1000) : 0;
+    task.wakeups = std::min<uint32_t>(switches, UINT16_MAX);
+    if (status[i].xHandle != idleTask) {
+      busy += task.load;
+    }
+  }
+  snapshot.idle = 1000 - std::min<uint32_t>(busy, 1000);
+  std::sort(snapshot.tasks.begin(), snapshot.tasks.begin() + snapshot.nbTasks, [](const Task& lhs, const Task& rhs) {
+    return lhs.load > rhs.load;
+  });
+
+  taskENTER_CRITICAL();
+  latest = snapshot;
+  taskEXIT_CRITICAL();
+}
+
+RunTimeStats::Snapshot RunTimeStats::Latest() const {
+  taskENTER_CRITICAL();
+  Snapshot snapshot = latest;
+  taskEXIT_CRITICAL();
+  return snapshot;
+}
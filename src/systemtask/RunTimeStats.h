@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <FreeRTOS.h>
+#include <task.h>
+
+namespace Pinetime {
+  namespace System {
+    // CPU usage of each task over a period, from the FreeRTOS run time stats (see FreeRTOS/port_runtime_stats.c).
+    // The run time counter keeps running while the CPU sleeps, which is charged to the idle task: idle is the part of
+    // the period not used by the other tasks, sleeping included.
+    class RunTimeStats {
+    public:
+      static constexpr uint8_t maxTasks = 10;
+
+      struct Task {
+        char name[configMAX_TASK_NAME_LEN];
+        uint16_t load;    // per mille of the period
+        uint16_t wakeups; // number of times the task was scheduled in during the period
+      };
+
+      struct Snapshot {
+        uint32_t period; // ms
+        uint16_t idle;   // per mille of the period
+        uint8_t nbTasks;
+        std::array<Task, maxTasks> tasks;
+      };
+
+      // Computes the usage of the period since the previous call
+      void Update();
+      // Usage of the last period, safe to call from any task
+      Snapshot Latest() const;
+
+    private:
+      struct Counters {
+        uint32_t runTime;
+        uint32_t switches;
+      };
+
+      // Indexed by task number
+      std::array<Counters, RUN_TIME_STATS_MAX_TASKS> previous {};
+      TickType_t lastUpdate = 0;
+      Snapshot latest {};
+      // Working buffers of Update(), about 450 bytes that would otherwise be on the stack of the system task
+      std::array<TaskStatus_t, maxTasks> status;
+      Snapshot snapshot;
+    };
+  }
+}
@@ -32,6 +32,31 @@ void MeasureBatteryTimerCallback(TimerHandle_t xTimer) {
   sysTask->PushMessage(Pinetime::System::Messages::MeasureBatteryTimerExpired);
 }
 
+void HousekeepingTimerCallback(TimerHandle_t xTimer) {
+  auto* sysTask = static_cast<SystemTask*>(pvTimerGetTimerID(xTimer));
+  sysTask->PushMessage(Pinetime::System::Messages::OnHousekeepingTimer);
+}
+
+void MotionPollTimerCallback(TimerHandle_t xTimer) {
+  auto* sysTask = static_cast<SystemTask*>(pvTimerGetTimerID(xTimer));
+  sysTask->PushMessage(Pinetime::System::Messages::OnMotionPollTimer);
+}
+
+void BleDiscoveryTimerCallback(TimerHandle_t xTimer) {
+  auto* sysTask = static_cast<SystemTask*>(pvTimerGetTimerID(xTimer));
+  sysTask->PushMessage(Pinetime::System::Messages::OnBleDiscoveryTimer);
+}
+
+void ActivityTimerCallback(TimerHandle_t xTimer) {
+  auto* sysTask = static_cast<SystemTask*>(pvTimerGetTimerID(xTimer));
+  sysTask->PushMessage(Pinetime::System::Messages::OnActivityMinute);
+}
+
+void SleepEpochTimerCallback(TimerHandle_t xTimer) {
+  auto* sysTask = static_cast<SystemTask*>(pvTimerGetTimerID(xTimer));
+  sysTask->PushMessage(Pinetime::System::Messages::OnSleepEpoch);
+}
+
 SystemTask::SystemTask(Drivers::SpiMaster& spi,
                        Pinetime::Drivers::SpiNorFlash& spiNorFlash,
                        Drivers::TwiMaster& twiMaster,
@@ -46,6 +71,8 @@ SystemTask::SystemTask(Drivers::SpiMaster& spi,
                        Pinetime::Drivers::Hrs3300& heartRateSensor,
                        Pinetime::Controllers::MotionController& motionController,
                        Pinetime::Drivers::Bma421& motionSensor,
+                       Pinetime::Controllers::ActivityHistory& activityHistory,
+                       Pinetime::Controllers::SleepTracker& sleepTracker,
                        Controllers::Settings& settingsController,
                        Pinetime::Controllers::HeartRateController& heartRateController,
                        Pinetime::Applications::DisplayApp& displayApp,
@@ -69,6 +96,8 @@ SystemTask::SystemTask(Drivers::SpiMaster& spi,
     settingsController {settingsController},
     heartRateController {heartRateController},
     motionController {motionController},
+    activityHistory {activityHistory},
+    sleepTracker {sleepTracker},
     displayApp {displayApp},
     heartRateApp(heartRateApp),
     fs {fs},
@@ -82,12 +111,14 @@ SystemTask::SystemTask(Drivers::SpiMaster& spi,
                      spiNorFlash,
                      heartRateController,
                      motionController,
-                     fs) {
+                     fs),
+    preEraseTask(fs) {
 }
 
 void SystemTask::Start() {
   systemTasksMsgQueue = xQueueCreate(10, 1);
-  if (pdPASS != xTaskCreate(SystemTask::Process, "MAIN", 350, this, 1, &taskHandle)) {
+  // The stack also holds a batch of motion samples read from the FIFO
+  if (pdPASS != xTaskCreate(SystemTask::Process, "MAIN", 400, this, 1, &taskHandle)) {
     APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
   }
 }
@@ -113,6 +144,7 @@ void SystemTask::Work() {
   spiNorFlash.Wakeup();
 
   fs.Init();
+  preEraseTask.Start();
   nimbleController.Init();
 
   twiMaster.Init();
@@ -180,16 +212,43 @@ void SystemTask::Work() {
   nrfx_gpiote_in_init(PinMap::PowerPresent, &pinConfig, nrfx_gpiote_evt_handler);
   nrfx_gpiote_in_event_enable(PinMap::PowerPresent, true);
 
+  // Motion sensor FIFO watermark
+  if (motionSensor.IsFifoEnabled()) {
+    pinConfig.sense = NRF_GPIOTE_POLARITY_LOTOHI;
+    pinConfig.pull = NRF_GPIO_PIN_NOPULL;
+    nrfx_gpiote_in_init(PinMap::Bma421Irq, &pinConfig, nrfx_gpiote_evt_handler);
+    nrfx_gpiote_in_event_enable(PinMap::Bma421Irq, true);
+  }
+
   batteryController.MeasureVoltage();
 
   measureBatteryTimer = xTimerCreate("measureBattery", batteryMeasurementPeriod, pdTRUE, this, MeasureBatteryTimerCallback);
   xTimerStart(measureBatteryTimer, portMAX_DELAY);
+  // The activity timer is restarted at each minute boundary of the clock, which can be changed at any time
+  activityHistory.Init();
+  activityTimer =
+    xTimerCreate("activity", pdMS_TO_TICKS(activityHistory.SecondsToNextMinute() * 1000), pdFALSE, this, ActivityTimerCallback);
+  xTimerStart(activityTimer, portMAX_DELAY);
+  sleepEpochTimer = xTimerCreate("sleepEpoch", sleepEpochPeriod, pdTRUE, this, SleepEpochTimerCallback);
+  xTimerStart(sleepEpochTimer, portMAX_DELAY);
+  housekeepingTimer = xTimerCreate("housekeeping", housekeepingPeriod, pdTRUE, this, HousekeepingTimerCallback);
+  xTimerStart(housekeepingTimer, portMAX_DELAY);
+  motionPollTimer = xTimerCreate("motionPoll", motionPollPeriod, pdTRUE, this, MotionPollTimerCallback);
+  if (!motionSensor.IsFifoEnabled()) {
+    xTimerStart(motionPollTimer, portMAX_DELAY);
+  }
+  // Services discovery is deferred to avoid the conflicts between the host communicating with the
+  // target and vice-versa. I'm not sure if this is the right way to handle this...
+  bleDiscoveryTimer = xTimerCreate("bleDiscovery", bleDiscoveryDelay, pdFALSE, this, BleDiscoveryTimerCallback);
 
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "EndlessLoop"
   while (true) {
     Messages msg;
-    if (xQueueReceive(systemTasksMsgQueue, &msg, 100) == pdTRUE) {
+    // Everything is driven by messages: interrupts, timers and the other tasks
+    if (xQueueReceive(systemTasksMsgQueue, &msg, portMAX_DELAY) == pdTRUE) {
+      wakeups++;
+      pendingMessages.Remove(msg);
       switch (msg) {
         case Messages::EnableSleeping:
           wakeLocksHeld--;
@@ -223,8 +282,10 @@ void SystemTask::Work() {
           break;
         case Messages::BleConnected:
           displayApp.PushMessage(Pinetime::Applications::Display::Messages::NotifyDeviceActivity);
-          isBleDiscoveryTimerRunning = true;
-          bleDiscoveryTimer = 5;
+          xTimerStart(bleDiscoveryTimer, portMAX_DELAY);
+          break;
+        case Messages::OnBleDiscoveryTimer:
+          nimbleController.StartDiscovery();
           break;
         case Messages::BleFirmwareUpdateStarted:
           GoToRunning();
@@ -296,22 +357,26 @@ void SystemTask::Work() {
           if (state != SystemTaskState::GoingToSleep) {
             break;
           }
-          if (BootloaderVersion::IsValid()) {
-            // First versions of the bootloader do not expose their version and cannot initialize the SPI NOR FLASH
-            // if it's in sleep mode. Avoid bricked device by disabling sleep mode on these versions.
-            spiNorFlash.Sleep();
-          }
-
-          // Must keep SPI awake when still updating the display for always on
-          if (msg == Messages::OnDisplayTaskSleeping) {
-            spi.Sleep();
-          }
+          fs.SaveEraseCounts();
+          // Erase the blocks the next writes will need while nothing happens, until the watch wakes up
+          preEraseTask.Run();
+          // First versions of the bootloader do not expose their version and cannot initialize the SPI NOR FLASH
+          // if it's in sleep mode. Avoid bricked device by disabling sleep mode on these versions.
+          // Must keep SPI awake when still updating the display for always on.
+          // The file system wakes them up for the tasks that write to it while the watch sleeps (background heart rate,
+          // histories, sleep tracking).
+          fs.Sleep(BootloaderVersion::IsValid(), msg == Messages::OnDisplayTaskSleeping ? &spi : nullptr);
 
           // Double Tap needs the touch screen to be in normal mode
           if (!settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::DoubleTap)) {
             touchPanel.Sleep();
           }
 
+          // Without the feature engine, raise to wake is detected in software: don't wait for a full FIFO batch
+          if (!motionSensor.AreFeatureInterruptsEnabled() && IsMotionWakeEnabled(Controllers::Settings::WakeUpMode::RaiseWrist)) {
+            motionSensor.SetFifoWatermark(screenOffFifoWatermark);
+          }
+
           if (msg == Messages::OnDisplayTaskSleeping) {
             state = SystemTaskState::Sleeping;
           } else {
@@ -344,6 +409,17 @@ void SystemTask::Work() {
         case Messages::MeasureBatteryTimerExpired:
           batteryController.MeasureVoltage();
           break;
+        case Messages::OnActivityMinute:
+          activityHistory.OnMinute();
+          xTimerChangePeriod(activityTimer, pdMS_TO_TICKS(activityHistory.SecondsToNextMinute() * 1000), 0);
+          wakeupsPerMinute = wakeups;
+          wakeups = 0;
+          NRF_LOG_INFO("[systemtask] %lu wakeups per minute", static_cast<unsigned long>(wakeupsPerMinute));
+          runTimeStats.Update();
+          break;
+        case Messages::OnSleepEpoch:
+          sleepTracker.OnEpoch();
+          break;
         case Messages::BatteryPercentageUpdated:
           nimbleController.NotifyBatteryLevel(batteryController.PercentRemaining());
           break;
@@ -358,48 +434,64 @@ void SystemTask::Work() {
             nimbleController.DisableRadio();
           }
           break;
+        case Messages::OnMotionInterrupt:
+          HandleMotionInterrupt();
+          break;
+        case Messages::OnMotionPollTimer:
+          UpdateMotion();
+          break;
+        case Messages::OnHousekeepingTimer:
+          Housekeeping();
+          break;
         default:
           break;
       }
     }
 
-    UpdateMotion();
-    if (isBleDiscoveryTimerRunning) {
-      if (bleDiscoveryTimer == 0) {
-        isBleDiscoveryTimerRunning = false;
-        // Services discovery is deferred from 3 seconds to avoid the conflicts between the host communicating with the
-        // target and vice-versa. I'm not sure if this is the right way to handle this...
-        nimbleController.StartDiscovery();
-      } else {
-        bleDiscoveryTimer--;
-      }
+    // In FIFO mode, the motion sensor is only read when it raises its interrupt pin.
+    // The pin level is checked too, in case the edge was missed (the interrupt is latched until the sensor is read).
+    if (motionSensor.IsFifoEnabled() && nrf_gpio_pin_read(PinMap::Bma421Irq) != 0) {
+      HandleMotionInterrupt();
     }
-
-    monitor.Process();
-    NoInit_BackUpTime = dateTimeController.CurrentDateTime();
-    if (nrf_gpio_pin_read(PinMap::Button) == 0) {
-      watchdog.Reload();
+    // While sleeping, the sensor only interrupts on gestures and steps
+    if ((state == SystemTaskState::Sleeping || state == SystemTaskState::AODSleeping) && !motionFeatureInterruptsMapped &&
+        motionSensor.AreFeatureInterruptsEnabled() && static_cast<int32_t>(xTaskGetTickCount() - motionSamplingEnd) >= 0) {
+      MapMotionFeatureInterrupts();
     }
   }
 #pragma clang diagnostic pop
 }
 
+void SystemTask::Housekeeping() {
+  monitor.Process();
+  // Also updates the clock, which sends the new hour and new day messages
+  NoInit_BackUpTime = dateTimeController.CurrentDateTime();
+  // Holding the button lets the watchdog reset the watch
+  if (nrf_gpio_pin_read(PinMap::Button) == 0) {
+    watchdog.Reload();
+  }
+}
+
 void SystemTask::GoToRunning() {
   if (state == SystemTaskState::Running) {
     return;
   }
   if (state == SystemTaskState::Sleeping || state == SystemTaskState::AODSleeping) {
-    // SPI only switched off when entering Sleeping, not AOD or GoingToSleep
-    if (state == SystemTaskState::Sleeping) {
-      spi.Wakeup();
-    }
+    preEraseTask.Stop();
+    // Powers the flash, and the SPI bus when it was switched off for Sleeping, see FS::Sleep()
+    fs.Wakeup();
 
     // Double Tap needs the touch screen to be in normal mode
     if (!settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::DoubleTap)) {
       touchPanel.Wakeup();
     }
+  }
 
-    spiNorFlash.Wakeup();
+  if (state == SystemTaskState::Sleeping || state == SystemTaskState::AODSleeping) {
+    // Also unmaps the wrist tilt interrupt kept with the FIFO watermark while the screen was off
+    motionSensor.MapFifoInterrupt();
+    motionSensor.SetFifoWatermark(Drivers::Bma421::fifoWatermark);
+    motionFeatureInterruptsMapped = false;
   }
 
   displayApp.PushMessage(Pinetime::Applications::Display::Messages::GoToRunning);
@@ -434,17 +526,35 @@ void SystemTask::UpdateMotion() {
   // Unconditionally update motion
   // Reading steps/motion characteristics must return up to date information even when not subscribed to notifications
 
-  auto motionValues = motionSensor.Process();
-
-  motionController.Update(motionValues.x, motionValues.y, motionValues.z, motionValues.steps);
+  bool raiseWake = false;
+  bool shakeWake = false;
+  auto updateController = [&](const Drivers::Bma421::Values& values, TickType_t timestamp) {
+    motionController.Update(values.x, values.y, values.z, values.steps, timestamp);
+    raiseWake |= motionController.ShouldRaiseWake();
+    shakeWake |= motionController.CurrentShakeSpeed() > settingsController.GetShakeThreshold();
+  };
+
+  if (motionSensor.IsFifoEnabled()) {
+    // Samples are timestamped backwards from now, the last one being the most recent
+    constexpr TickType_t samplePeriod = Drivers::Bma421::fifoSamplePeriodMs * configTICK_RATE_HZ / 1000;
+    Drivers::Bma421::Values samples[Drivers::Bma421::maxFifoSamples];
+    uint8_t count;
+    do {
+      TickType_t now = xTaskGetTickCount();
+      bool wristTilt = false;
+      count = motionSensor.ReadFifo(samples, Drivers::Bma421::maxFifoSamples, &wristTilt);
+      raiseWake |= wristTilt;
+      for (uint8_t i = 0; i < count; i++) {
+        updateController(samples[i], now - (count - 1 - i) * samplePeriod);
+      }
+    } while (count == Drivers::Bma421::maxFifoSamples);
+  } else {
+    updateController(motionSensor.Process(), xTaskGetTickCount());
+  }
 
-  if (settingsController.GetNotificationStatus() != Controllers::Settings::Notification::Sleep) {
-    if ((settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::RaiseWrist) &&
-         motionController.ShouldRaiseWake()) ||
-        (settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::Shake) &&
-         motionController.CurrentShakeSpeed() > settingsController.GetShakeThreshold())) {
-      GoToRunning();
-    }
+  if ((raiseWake && IsMotionWakeEnabled(Controllers::Settings::WakeUpMode::RaiseWrist)) ||
+      (shakeWake && IsMotionWakeEnabled(Controllers::Settings::WakeUpMode::Shake))) {
+    GoToRunning();
   }
   if (settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::LowerWrist) && state == SystemTaskState::Running &&
       motionController.ShouldLowerSleep()) {
@@ -452,6 +562,36 @@ void SystemTask::UpdateMotion() {
   }
 }
 
+void SystemTask::HandleMotionInterrupt() {
+  if (!motionFeatureInterruptsMapped) {
+    UpdateMotion();
+    return;
+  }
+
+  auto events = motionSensor.ReadFeatureEvents();
+  motionController.UpdateSteps(events.steps);
+  if (events.wristTilt) {
+    GoToRunning();
+  } else if (events.anyMotion) {
+    // Let the software detection decide whether this movement is a shake.
+    // The wrist tilt interrupt stays mapped, so that raise to wake doesn't wait for a FIFO batch.
+    motionSensor.MapFifoInterrupt(IsMotionWakeEnabled(Controllers::Settings::WakeUpMode::RaiseWrist));
+    motionFeatureInterruptsMapped = false;
+    motionSamplingEnd = xTaskGetTickCount() + motionSamplingDuration;
+  }
+}
+
+void SystemTask::MapMotionFeatureInterrupts() {
+  // Any-motion is mapped whatever the wake settings: the samples it starts also feed the sleep tracker.
+  // Whether a shake wakes the screen up is decided by UpdateMotion().
+  motionSensor.MapFeatureInterrupts(IsMotionWakeEnabled(Controllers::Settings::WakeUpMode::RaiseWrist), true);
+  motionFeatureInterruptsMapped = true;
+}
+
+bool SystemTask::IsMotionWakeEnabled(Controllers::Settings::WakeUpMode mode) const {
+  return settingsController.GetNotificationStatus() != Controllers::Settings::Notification::Sleep && settingsController.isWakeUpModeOn(mode);
+}
+
 void SystemTask::HandleButtonAction(Controllers::ButtonActions action) {
   if (IsSleeping()) {
     return;
@@ -485,9 +625,14 @@ void SystemTask::HandleButtonAction(Controllers::ButtonActions action) {
 }
 
 void SystemTask::PushMessage(System::Messages msg) {
+  if (!pendingMessages.Add(msg)) {
+    return;
+  }
   if (in_isr()) {
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-    xQueueSendFromISR(systemTasksMsgQueue, &msg, &xHigherPriorityTaskWoken);
+    if (xQueueSendFromISR(systemTasksMsgQueue, &msg, &xHigherPriorityTaskWoken) != pdTRUE) {
+      pendingMessages.Remove(msg);
+    }
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
   } else {
     xQueueSend(systemTasksMsgQueue, &msg, portMAX_DELAY);
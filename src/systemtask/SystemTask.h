@@ -11,8 +11,13 @@
 #include <drivers/Bma421.h>
 #include <drivers/PinMap.h>
 #include <components/motion/MotionController.h>
+#include <components/motion/ActivityHistory.h>
+#include <components/motion/SleepTracker.h>
 
 #include "systemtask/SystemMonitor.h"
+#include "systemtask/RunTimeStats.h"
+#include "systemtask/PreEraseTask.h"
+#include "utility/PendingMessages.h"
 #include "components/ble/NimbleController.h"
 #include "components/ble/NotificationManager.h"
 #include "components/stopwatch/StopWatchController.h"
@@ -68,6 +73,8 @@ namespace Pinetime {
                  Pinetime::Drivers::Hrs3300& heartRateSensor,
                  Pinetime::Controllers::MotionController& motionController,
                  Pinetime::Drivers::Bma421& motionSensor,
+                 Pinetime::Controllers::ActivityHistory& activityHistory,
+                 Pinetime::Controllers::SleepTracker& sleepTracker,
                  Controllers::Settings& settingsController,
                  Pinetime::Controllers::HeartRateController& heartRateController,
                  Pinetime::Applications::DisplayApp& displayApp,
@@ -99,6 +106,16 @@ namespace Pinetime {
         return state != SystemTaskState::Running;
       }
 
+      // Number of times the task woke up during the previous minute
+      uint32_t WakeupsPerMinute() const {
+        return wakeupsPerMinute;
+      }
+
+      // CPU usage of the tasks during the previous minute
+      const RunTimeStats& GetRunTimeStats() const {
+        return runTimeStats;
+      }
+
     private:
       TaskHandle_t taskHandle;
 
@@ -113,6 +130,15 @@ namespace Pinetime {
       Pinetime::Controllers::StopWatchController& stopWatchController;
       Pinetime::Controllers::AlarmController& alarmController;
       QueueHandle_t systemTasksMsgQueue;
+      // Interrupts and timers can fire faster than they are handled, and their messages only need to be handled once
+      Utility::PendingMessages<Messages> pendingMessages {Messages::OnTouchEvent,
+                                                          Messages::OnNewTime,
+                                                          Messages::OnChargingEvent,
+                                                          Messages::MeasureBatteryTimerExpired,
+                                                          Messages::BatteryPercentageUpdated,
+                                                          Messages::OnMotionInterrupt,
+                                                          Messages::OnHousekeepingTimer,
+                                                          Messages::OnMotionPollTimer};
       Pinetime::Drivers::Watchdog& watchdog;
       Pinetime::Controllers::NotificationManager& notificationManager;
       Pinetime::Drivers::Hrs3300& heartRateSensor;
@@ -120,6 +146,8 @@ namespace Pinetime {
       Pinetime::Controllers::Settings& settingsController;
       Pinetime::Controllers::HeartRateController& heartRateController;
       Pinetime::Controllers::MotionController& motionController;
+      Pinetime::Controllers::ActivityHistory& activityHistory;
+      Pinetime::Controllers::SleepTracker& sleepTracker;
 
       Pinetime::Applications::DisplayApp& displayApp;
       Pinetime::Applications::HeartRateTask& heartRateApp;
@@ -130,9 +158,12 @@ namespace Pinetime {
 
       static void Process(void* instance);
       void Work();
-      bool isBleDiscoveryTimerRunning = false;
-      uint8_t bleDiscoveryTimer = 0;
+      TimerHandle_t bleDiscoveryTimer;
+      TimerHandle_t housekeepingTimer;
+      TimerHandle_t motionPollTimer;
       TimerHandle_t measureBatteryTimer;
+      TimerHandle_t activityTimer;
+      TimerHandle_t sleepEpochTimer;
       uint8_t wakeLocksHeld = 0;
       SystemTaskState state = SystemTaskState::Running;
 
@@ -141,10 +172,30 @@ namespace Pinetime {
 
       void GoToRunning();
       void GoToSleep();
+      void Housekeeping();
       void UpdateMotion();
+      void HandleMotionInterrupt();
+      void MapMotionFeatureInterrupts();
+      bool IsMotionWakeEnabled(Controllers::Settings::WakeUpMode mode) const;
+      bool motionFeatureInterruptsMapped = false;
+      TickType_t motionSamplingEnd = 0;
+      // Samples are read for this long after an any-motion interrupt while sleeping, to detect shakes
+      static constexpr TickType_t motionSamplingDuration = pdMS_TO_TICKS(3000);
+      // FIFO watermark while the screen is off without the feature engine: 80ms, the sensor was polled every 100ms
+      static constexpr uint8_t screenOffFifoWatermark = 1;
+      // Feeds the watchdog (7s timeout) and updates the clock, which raises the hour and day events
+      static constexpr TickType_t housekeepingPeriod = pdMS_TO_TICKS(2000);
+      // Without the FIFO, the motion sensor is polled
+      static constexpr TickType_t motionPollPeriod = pdMS_TO_TICKS(100);
+      static constexpr TickType_t bleDiscoveryDelay = pdMS_TO_TICKS(500);
       static constexpr TickType_t batteryMeasurementPeriod = pdMS_TO_TICKS(10 * 60 * 1000);
+      static constexpr TickType_t sleepEpochPeriod = pdMS_TO_TICKS(Controllers::Actigraphy::epochDuration * 1000);
 
       SystemMonitor monitor;
+      RunTimeStats runTimeStats;
+      PreEraseTask preEraseTask;
+      uint32_t wakeups = 0;
+      uint32_t wakeupsPerMinute = 0;
     };
   }
 }
@@ -0,0 +1,132 @@
+#include "utility/FlashTelemetry.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <nrf.h>
+
+using namespace Pinetime::Utility;
+
+namespace {
+  struct Group {
+    TaskHandle_t task;
+    char name[configMAX_TASK_NAME_LEN];
+    std::array<FlashTelemetry::Counters, FlashTelemetry::nbOperations> counters;
+  };
+
+  static_assert(configMAX_TASK_NAME_LEN == sizeof(uint32_t), "The task names are dumped as one word");
+
+  constexpr uint8_t dumpVersion = 1;
+  // The dump is a sequence of words: the header, the groups, then the histograms
+  constexpr size_t headerWords = 2;
+  constexpr size_t groupWords = 1 + FlashTelemetry::nbOperations * sizeof(FlashTelemetry::Counters) / sizeof(uint32_t);
+  constexpr size_t histogramWords = FlashTelemetry::nbOperations * FlashTelemetry::nbBuckets;
+
+  std::array<Group, FlashTelemetry::nbGroups> groups;
+  size_t nbUsedGroups = 0;
+  size_t dumpGroups = 0; // groups in the dump, fixed by Rewind()
+  std::array<std::array<uint32_t, FlashTelemetry::nbBuckets>, FlashTelemetry::nbOperations> histograms;
+
+  // The last group is shared by the tasks that came after the others. Called in a critical section.
+  Group& CurrentGroup() {
+    TaskHandle_t task = xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED ? nullptr : xTaskGetCurrentTaskHandle();
+    for (size_t i = 0; i < nbUsedGroups; i++) {
+      if (groups[i].task == task) {
+        return groups[i];
+      }
+    }
+    if (nbUsedGroups == groups.size()) {
+      return groups.back();
+    }
+    Group& group = groups[nbUsedGroups++];
+    group.task = task;
+    if (nbUsedGroups < groups.size() && task != nullptr) {
+      std::strncpy(group.name, pcTaskGetName(task), sizeof(group.name));
+    }
+    return group;
+  }
+
+  size_t Bucket(uint32_t ticks) {
+    size_t bucket = 0;
+    for (uint32_t limit = 1; bucket < FlashTelemetry::nbBuckets - 1 && ticks >= limit; limit <<= 2) {
+      bucket++;
+    }
+    return bucket;
+  }
+
+  size_t DumpSize() {
+    return (headerWords + dumpGroups * groupWords + histogramWords) * sizeof(uint32_t);
+  }
+
+  uint32_t Word(size_t index) {
+    if (index < headerWords) {
+      if (index == 0) {
+        return dumpVersion | (FlashTelemetry::nbOperations << 8) | (FlashTelemetry::nbBuckets << 16) | (dumpGroups << 24);
+      }
+      return static_cast<uint64_t>(xTaskGetTickCount()) * 1000 / configTICK_RATE_HZ;
+    }
+    index -= headerWords;
+    if (index < dumpGroups * groupWords) {
+      const Group& group = groups[index / groupWords];
+      index %= groupWords;
+      uint32_t word;
+      if (index == 0) {
+        std::memcpy(&word, group.name, sizeof(word));
+      } else {
+        std::memcpy(&word, reinterpret_cast<const uint32_t*>(group.counters.data()) + index - 1, sizeof(word));
+      }
+      return word;
+    }
+    index -= dumpGroups * groupWords;
+    return histograms[index / FlashTelemetry::nbBuckets][index % FlashTelemetry::nbBuckets];
+  }
+}
+
+uint32_t FlashTelemetry::Start() {
+  return NRF_RTC0->COUNTER;
+}
+
+void FlashTelemetry::Record(Operation operation, uint32_t start, uint32_t bytes) {
+  uint32_t ticks = (NRF_RTC0->COUNTER - start) & 0x00FFFFFF;
+  auto index = static_cast<size_t>(operation);
+  taskENTER_CRITICAL();
+  auto& counters = CurrentGroup().counters[index];
+  counters.count++;
+  counters.bytes += bytes;
+  counters.ticks += ticks;
+  histograms[index][Bucket(ticks)]++;
+  taskEXIT_CRITICAL();
+}
+
+FlashTelemetry::Counters FlashTelemetry::Total(Operation operation) {
+  Counters total {};
+  taskENTER_CRITICAL();
+  for (size_t i = 0; i < nbUsedGroups; i++) {
+    const auto& counters = groups[i].counters[static_cast<size_t>(operation)];
+    total.count += counters.count;
+    total.bytes += counters.bytes;
+    total.ticks += counters.ticks;
+  }
+  taskEXIT_CRITICAL();
+  return total;
+}
+
+size_t FlashTelemetry::Rewind() {
+  dumpGroups = nbUsedGroups;
+  return DumpSize();
+}
+
+size_t FlashTelemetry::ReadDump(size_t offset, uint8_t* buffer, size_t size) {
+  size_t copied = 0;
+  size_t dumpSize = DumpSize();
+  while (copied < size && offset < dumpSize) {
+    uint32_t word = Word(offset / sizeof(uint32_t));
+    size_t wordOffset = offset % sizeof(uint32_t);
+    size_t chunk = std::min(size - copied, sizeof(uint32_t) - wordOffset);
+    std::memcpy(buffer + copied, reinterpret_cast<uint8_t*>(&word) + wordOffset, chunk);
+    copied += chunk;
+    offset += chunk;
+  }
+  return copied;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Pinetime {
+  namespace Utility {
+    // Counters and latency histograms of the block device operations of littlefs and of the commands of the external
+    // flash, to find which features stall on the flash. The latency is measured with the 32768Hz RTC0 counter.
+    // The counters are grouped by calling task: the first tasks to use the flash get their own group, the following
+    // ones share the last group. They are dumped over BLE by the diagnostics service, with the erase counts of the
+    // blocks of the file system, see doc/DiagnosticsService.md.
+    namespace FlashTelemetry {
+      // The values are part of the dump format
+      enum class Operation : uint8_t {
+        BlockRead,    // littlefs read, served from the read-ahead buffer or the flash
+        BlockProg,    // littlefs prog, queued by SpiNorFlash
+        BlockErase,   // littlefs erase, skipped when the block was erased ahead of time
+        BlockSync,    // littlefs sync, waits for the queued programs
+        FlashRead,    // read command
+        FlashProgram, // page program, from the command until the next command finds the flash ready
+        FlashErase,   // sector erase, from the command until the flash is ready
+      };
+
+      static constexpr size_t nbOperations = 7;
+      // Bucket i counts the operations shorter than 4^i ticks, the last one the longer operations
+      static constexpr size_t nbBuckets = 8;
+      static constexpr size_t nbGroups = 5;
+
+      struct Counters {
+        uint32_t count;
+        uint32_t bytes;
+        uint32_t ticks; // total latency
+      };
+
+      // Returns the start of an operation, to pass to Record()
+      uint32_t Start();
+      void Record(Operation operation, uint32_t start, uint32_t bytes = 0);
+
+      // Sum of the groups
+      Counters Total(Operation operation);
+
+      // Starts a dump, and returns its size in bytes. The counters keep running while the dump is read.
+      size_t Rewind();
+      // Copies up to size bytes of the dump from offset, and returns the number of bytes copied
+      size_t ReadDump(size_t offset, uint8_t* buffer, size_t size);
+    }
+  }
+}
@@ -1,49 +1,80 @@
 #include "utility/Math.h"
 
-#include <lvgl/src/lv_misc/lv_math.h>
+#include <array>
+#include <cstddef>
 
 using namespace Pinetime::Utility;
 
-#ifndef PINETIME_IS_RECOVERY
+namespace {
+  constexpr double Sine(double x) {
+    // Taylor series, accurate to well below 1/32767 for 0 <= x <= pi/2
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 12; n++) {
+      term *= -x * x / ((2 * n) * (2 * n + 1));
+      sum += term;
+    }
+    return sum;
+  }
 
-int16_t Pinetime::Utility::Asin(int16_t arg) {
-  int16_t a = arg < 0 ? -arg : arg;
-
-  int16_t angle = 45;
-  int16_t low = 0;
-  int16_t high = 90;
-  while (low <= high) {
-    int16_t sinAngle = _lv_trigo_sin(angle);
-    int16_t sinAngleSub = _lv_trigo_sin(angle - 1);
-    int16_t sinAngleAdd = _lv_trigo_sin(angle + 1);
-
-    if (a >= sinAngleSub && a <= sinAngleAdd) {
-      if (a <= (sinAngleSub + sinAngle) / 2) {
-        angle--;
-      } else if (a > (sinAngle + sinAngleAdd) / 2) {
+  // sin(degrees) * 32767, rounded like the LVGL sine table
+  constexpr int32_t ScaledSine(int32_t degrees) {
+    return static_cast<int32_t>(Sine(degrees * 3.14159265358979323846 / 180) * 32767 + 0.5);
+  }
+
+  // Asin(a) is the number of thresholds below a: the angle whose sine is the closest to a
+  constexpr auto asinThresholds = [] {
+    std::array<uint16_t, 90> thresholds {};
+    for (int32_t angle = 0; angle < 90; angle++) {
+      thresholds[angle] = static_cast<uint16_t>((ScaledSine(angle) + ScaledSine(angle + 1)) / 2);
+    }
+    return thresholds;
+  }();
+
+  // Smallest result for each range of 512 arguments
+  constexpr uint8_t asinBucketShift = 9;
+  constexpr auto asinBuckets = [] {
+    std::array<uint8_t, (32767 >> asinBucketShift) + 1> buckets {};
+    for (std::size_t bucket = 0; bucket < buckets.size(); bucket++) {
+      uint8_t angle = 0;
+      while (angle < 90 && static_cast<int32_t>(bucket << asinBucketShift) > asinThresholds[angle]) {
         angle++;
       }
-      break;
+      buckets[bucket] = angle;
     }
+    return buckets;
+  }();
+}
 
-    if (a < sinAngle) {
-      high = angle - 1;
+uint16_t Pinetime::Utility::Sqrt(uint32_t arg) {
+  uint32_t result = 0;
+  uint32_t bit = 1UL << 30;
+  while (bit > arg) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (arg >= result + bit) {
+      arg -= result + bit;
+      result = (result >> 1) + bit;
+    } else {
+      result >>= 1;
     }
+    bit >>= 2;
+  }
+  return static_cast<uint16_t>(result);
+}
 
-    else {
-      low = angle + 1;
-    }
+int16_t Pinetime::Utility::Asin(int16_t arg) {
+  int32_t a = arg < 0 ? -static_cast<int32_t>(arg) : arg;
+  if (a > 32767) {
+    a = 32767;
+  }
 
-    angle = (low + high) / 2;
+  // Start from the smallest angle of the bucket, then step over the few thresholds it contains
+  uint8_t angle = asinBuckets[a >> asinBucketShift];
+  while (angle < 90 && a > asinThresholds[angle]) {
+    angle++;
   }
 
   return arg < 0 ? -angle : angle;
 }
-
-#else
-
-int16_t Pinetime::Utility::Asin(int16_t /*arg*/) {
-  return 0;
-}
-
-#endif
@@ -6,5 +6,8 @@ namespace Pinetime {
   namespace Utility {
     // returns the arcsin of `arg`. asin(-32767) = -90, asin(32767) = 90
     int16_t Asin(int16_t arg);
+
+    // returns the integer square root of `arg`, rounded down
+    uint16_t Sqrt(uint32_t arg);
   }
 }
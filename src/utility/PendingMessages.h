@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+
+namespace Pinetime {
+  namespace Utility {
+    // Tracks which messages of a queue are pending, so that a message which is already waiting in the queue
+    // is not queued again. Only for messages that carry no data and whose handling is idempotent.
+    // Safe to use from interrupts.
+    template <class Message>
+    class PendingMessages {
+    public:
+      explicit constexpr PendingMessages(std::initializer_list<Message> coalesced) {
+        for (auto message : coalesced) {
+          coalescedMask |= Bit(message);
+        }
+      }
+
+      // Returns false when the message is already pending, and must not be queued
+      bool Add(Message message) {
+        uint32_t bit = Bit(message) & coalescedMask;
+        return bit == 0 || (pending.fetch_or(bit) & bit) == 0;
+      }
+
+      // To be called when the message is received, before handling it
+      void Remove(Message message) {
+        pending.fetch_and(~Bit(message));
+      }
+
+    private:
+      static constexpr uint32_t Bit(Message message) {
+        return static_cast<uint8_t>(message) < 32 ? 1U << static_cast<uint8_t>(message) : 0;
+      }
+
+      uint32_t coalescedMask = 0;
+      std::atomic<uint32_t> pending {0};
+    };
+  }
+}
@@ -0,0 +1,117 @@
+#include "utility/Trace.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <nrf.h>
+
+using namespace Pinetime::Utility;
+
+namespace {
+  static_assert((Trace::capacity & (Trace::capacity - 1)) == 0, "The capacity must be a power of 2");
+
+  // header is written last: its event is None while the record is being written
+  struct TraceRecord {
+    volatile uint32_t header; // RTC0 counter << 8 | event
+    volatile uint32_t argument;
+  };
+
+  struct __attribute__((packed)) DumpHeader {
+    uint8_t version;
+    uint8_t recordSize;
+    uint16_t count;
+    uint32_t dropped;
+    uint32_t counter; // RTC0 counter when the ring was frozen
+    uint32_t uptime;  // ms
+    uint8_t nbTasks;
+  };
+
+  struct __attribute__((packed)) DumpTask {
+    uint8_t number;
+    char name[configMAX_TASK_NAME_LEN];
+  };
+
+  constexpr uint8_t dumpVersion = 1;
+  constexpr size_t maxTasks = 10;
+
+  std::array<TraceRecord, Trace::capacity> records;
+  std::atomic<uint32_t> head {0};
+  std::atomic<uint32_t> dropped {0};
+  std::atomic_bool frozen {false};
+
+  // Snapshot taken by Freeze(): the header and the task names, followed by the records
+  std::array<uint8_t, sizeof(DumpHeader) + maxTasks * sizeof(DumpTask)> dumpPrefix;
+  size_t dumpPrefixSize = 0;
+  uint32_t dumpFirst = 0;
+  uint32_t dumpCount = 0;
+}
+
+void Trace::Record(Event event, uint32_t argument) {
+  if (frozen.load(std::memory_order_relaxed)) {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto& record = records[head.fetch_add(1, std::memory_order_relaxed) & (capacity - 1)];
+  record.header = 0;
+  record.argument = argument;
+  record.header = (NRF_RTC0->COUNTER << 8) | static_cast<uint8_t>(event);
+}
+
+// Records being written when the ring is frozen are completed within a few us, long before the first read over BLE
+size_t Trace::Freeze() {
+  frozen = true;
+  uint32_t end = head.load();
+  dumpCount = std::min<uint32_t>(end, capacity);
+  dumpFirst = end - dumpCount;
+
+  std::array<TaskStatus_t, maxTasks> status;
+  auto nbTasks = uxTaskGetSystemState(status.data(), status.size(), nullptr);
+  DumpHeader header {dumpVersion,
+                     sizeof(TraceRecord),
+                     static_cast<uint16_t>(dumpCount),
+                     dropped.load(),
+                     NRF_RTC0->COUNTER,
+                     static_cast<uint32_t>(static_cast<uint64_t>(xTaskGetTickCount()) * 1000 / configTICK_RATE_HZ),
+                     static_cast<uint8_t>(nbTasks)};
+  std::memcpy(dumpPrefix.data(), &header, sizeof(header));
+  dumpPrefixSize = sizeof(header);
+  for (UBaseType_t i = 0; i < nbTasks; i++) {
+    DumpTask task {};
+    task.number = status[i].xTaskNumber;
+    std::strncpy(task.name, status[i].pcTaskName, sizeof(task.name) - 1);
+    std::memcpy(dumpPrefix.data() + dumpPrefixSize, &task, sizeof(task));
+    dumpPrefixSize += sizeof(task);
+  }
+  return dumpPrefixSize + dumpCount * sizeof(TraceRecord);
+}
+
+size_t Trace::ReadDump(size_t offset, uint8_t* buffer, size_t size) {
+  size_t copied = 0;
+  if (offset < dumpPrefixSize) {
+    copied = std::min(size, dumpPrefixSize - offset);
+    std::memcpy(buffer, dumpPrefix.data() + offset, copied);
+    offset = 0;
+  } else {
+    offset -= dumpPrefixSize;
+  }
+  while (copied < size && offset < dumpCount * sizeof(TraceRecord)) {
+    const auto& record = records[(dumpFirst + offset / sizeof(TraceRecord)) & (capacity - 1)];
+    uint32_t words[2] = {record.header, record.argument};
+    size_t recordOffset = offset % sizeof(TraceRecord);
+    size_t chunk = std::min(size - copied, sizeof(TraceRecord) - recordOffset);
+    std::memcpy(buffer + copied, reinterpret_cast<uint8_t*>(words) + recordOffset, chunk);
+    copied += chunk;
+    offset += chunk;
+  }
+  return copied;
+}
+
+void Trace::Resume() {
+  frozen = false;
+}
+
+extern "C" void TraceTaskSwitchedIn(uint32_t taskNumber) {
+  Trace::Record(Trace::Event::TaskSwitch, taskNumber);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Pinetime {
+  namespace Utility {
+    // Binary event trace, to diagnose latency issues on watches without debugger nor logs.
+    // The last events are kept in a ring buffer in RAM, timestamped with the 32768Hz RTC0 counter.
+    // Recording is lock-free and can be done from tasks and interrupt handlers.
+    // The ring is dumped over BLE by the diagnostics service, and decoded by tools/trace-decode.py.
+    namespace Trace {
+      // The values are part of the dump format
+      enum class Event : uint8_t {
+        None = 0,
+        TaskSwitch = 1,        // task number
+        SpiStart = 2,          // chip select pin << 24 | size
+        SpiEnd = 3,            // chip select pin << 24
+        TwiStart = 4,          // write << 16 | device address << 8 | register
+        TwiEnd = 5,            // TwiMaster::ErrorCodes
+        DisplayFlushStart = 6, // first line << 16 | number of lines
+        DisplayFlushEnd = 7,
+        BleGapEvent = 8,       // BLE_GAP_EVENT_*
+        FsStart = 9,           // size << 8 | FsOperation
+        FsEnd = 10,            // result
+        FlashEraseStart = 11,  // address
+        FlashEraseEnd = 12,
+        Mark = 13,
+      };
+
+      enum class FsOperation : uint8_t {
+        FileOpen,
+        FileClose,
+        FileRead,
+        FileWrite,
+        FileSeek,
+        FileDelete,
+        DirOpen,
+        DirClose,
+        DirRead,
+        DirRewind,
+        DirCreate,
+        Rename,
+        Stat,
+        GetAttribute,
+        SetAttributes,
+        RemoveAttribute,
+      };
+
+      static constexpr size_t capacity = 256; // records, must be a power of 2
+
+      void Record(Event event, uint32_t argument = 0);
+
+      // Stops recording and takes a snapshot of the ring, returns the size of the dump in bytes.
+      // Events recorded until Resume() is called are dropped.
+      size_t Freeze();
+      // Copies up to size bytes of the dump from offset, and returns the number of bytes copied
+      size_t ReadDump(size_t offset, uint8_t* buffer, size_t size);
+      void Resume();
+    }
+  }
+}
+
+extern "C" void TraceTaskSwitchedIn(uint32_t taskNumber);
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+
+# Decodes the flash telemetry of the watch (see src/utility/FlashTelemetry.h): the counters and latencies of the
+# flash operations by task, and the erase counts of the blocks of the file system.
+#
+# The dump is either read from a file, or fetched over BLE from the diagnostics service
+# (doc/DiagnosticsService.md), which needs the bleak package:
+#
+#   flash-decode.py --address AA:BB:CC:DD:EE:FF --save flash.bin
+#   flash-decode.py flash.bin
+
+import argparse
+import asyncio
+import struct
+import sys
+
+FLASH_CHAR_UUID = "00060003-78fc-48fe-8e23-433b3a1942d0"
+COUNTER_FREQUENCY = 32768
+BLOCK_SIZE = 4096
+
+OPERATIONS = ["BlockRead", "BlockProg", "BlockErase", "BlockSync", "FlashRead", "FlashProgram", "FlashErase"]
+
+
+def erase_count(code):
+    exponent, mantissa = code >> 4, code & 0x0f
+    return mantissa if exponent == 0 else (16 + mantissa) << (exponent - 1)
+
+
+def operation_name(index):
+    return OPERATIONS[index] if index < len(OPERATIONS) else str(index)
+
+
+def parse(data):
+    header, uptime = struct.unpack_from("<II", data)
+    version, nb_operations, nb_buckets, nb_groups = header & 0xff, (header >> 8) & 0xff, (header >> 16) & 0xff, \
+        header >> 24
+    if version != 1:
+        sys.exit("Unsupported telemetry version %d" % version)
+    offset = 8
+    groups = []
+    for index in range(nb_groups):
+        name = data[offset:offset + 4].split(b"\0")[0].decode(errors="replace")
+        if not name:
+            name = "other" if index == nb_groups - 1 else "?"
+        offset += 4
+        counters = []
+        for _ in range(nb_operations):
+            counters.append(struct.unpack_from("<III", data, offset))
+            offset += 12
+        groups.append((name, counters))
+    histograms = []
+    for _ in range(nb_operations):
+        histograms.append(struct.unpack_from("<%dI" % nb_buckets, data, offset))
+        offset += 4 * nb_buckets
+    erase_counts = [erase_count(code) for code in data[offset:]]
+    return uptime, groups, histograms, erase_counts
+
+
+def report(data):
+    uptime, groups, histograms, erase_counts = parse(data)
+    print("Uptime %.1f s\n" % (uptime / 1000))
+    print("%-5s %-13s %9s %11s %10s %10s" % ("Task", "Operation", "count", "KB", "mean ms", "total ms"))
+    for name, counters in groups:
+        for index, (count, size, ticks) in enumerate(counters):
+            if count == 0:
+                continue
+            total = ticks * 1000.0 / COUNTER_FREQUENCY
+            print("%-5s %-13s %9d %11.1f %10.3f %10.1f" % (name, operation_name(index), count, size / 1024,
+                                                          total / count, total))
+
+    nb_buckets = len(histograms[0]) if histograms else 0
+    limits = ["<%.3g" % (4 ** i * 1000.0 / COUNTER_FREQUENCY) for i in range(nb_buckets - 1)]
+    limits.append(">=%.3g" % (4 ** (nb_buckets - 2) * 1000.0 / COUNTER_FREQUENCY))
+    print("\nLatency, ms")
+    print("%-13s" % "" + "".join("%9s" % limit for limit in limits))
+    for index, buckets in enumerate(histograms):
+        print("%-13s" % operation_name(index) + "".join("%9d" % count for count in buckets))
+
+    if erase_counts:
+        used = [count for count in erase_counts if count > 0]
+        print("\n%d blocks, %d erases, %d blocks erased" % (len(erase_counts), sum(erase_counts), len(used)))
+        if used:
+            print("Erases per erased block: min %d, mean %.1f, max %d (block %d)" %
+                  (min(used), sum(used) / len(used), max(used), erase_counts.index(max(used))))
+
+
+async def fetch(address):
+    from bleak import BleakClient
+
+    async with BleakClient(address) as client:
+        await client.write_gatt_char(FLASH_CHAR_UUID, b"\x01", response=True)
+        data = bytearray()
+        while True:
+            chunk = await client.read_gatt_char(FLASH_CHAR_UUID)
+            if not chunk:
+                return bytes(data)
+            data += chunk
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the flash telemetry of the watch")
+    parser.add_argument("file", nargs="?", help="telemetry dump")
+    parser.add_argument("--address", help="fetch the telemetry from the watch with this BLE address")
+    parser.add_argument("--save", help="save the fetched telemetry to this file")
+    args = parser.parse_args()
+
+    if args.address:
+        data = asyncio.run(fetch(args.address))
+        if args.save:
+            with open(args.save, "wb") as f:
+                f.write(data)
+    elif args.file:
+        with open(args.file, "rb") as f:
+            data = f.read()
+    else:
+        parser.error("a file or an address is needed")
+    report(data)
+
+
+if __name__ == "__main__":
+    main()
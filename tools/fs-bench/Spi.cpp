@@ -0,0 +1,214 @@
+#include "drivers/Spi.h"
+#include <algorithm>
+#include <cstring>
+#include <libraries/delay/nrf_delay.h>
+#include <task.h>
+
+using namespace Pinetime::Drivers;
+
+namespace {
+  constexpr uint32_t pageSize = 256;
+  constexpr uint32_t sectorSize = 4096;
+  constexpr uint8_t identification[] = {0x0B, 0x40, 0x16};
+
+  uint64_t now = 0;
+
+  uint32_t Address(const uint8_t* cmd) {
+    return (cmd[1] << 16) | (cmd[2] << 8) | cmd[3];
+  }
+}
+
+uint64_t Spi::Now() {
+  return now;
+}
+
+void Spi::Advance(uint64_t us) {
+  now += us;
+}
+
+TickType_t xTaskGetTickCount() {
+  return now * configTICK_RATE_HZ / 1000000;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  Spi::Advance(std::max<uint64_t>(ticks, 1) * 1000000 / configTICK_RATE_HZ);
+}
+
+void nrf_delay_us(uint32_t us) {
+  Spi::Advance(us);
+}
+
+Spi::Spi() : memory(flashSize, 0xFF) {
+}
+
+bool Spi::Init() {
+  return true;
+}
+
+bool Spi::Write(const uint8_t* data, size_t size, const std::function<void()>& preTransactionHook) {
+  if (preTransactionHook != nullptr) {
+    preTransactionHook();
+  }
+  Transaction(data, size, nullptr, 0, nullptr);
+  return true;
+}
+
+bool Spi::Read(uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize) {
+  Transaction(cmd, cmdSize, nullptr, dataSize, data);
+  return true;
+}
+
+bool Spi::ReadChunks(uint8_t* cmd,
+                     size_t cmdSize,
+                     uint8_t* buffer,
+                     size_t bufferSize,
+                     size_t size,
+                     const std::function<void(const uint8_t*, size_t)>& onChunk) {
+  // The chip select stays asserted: the memory is read chunk after chunk from the address of the command
+  Account(cmdSize + size);
+  uint8_t chunkCmd[8];
+  std::memcpy(chunkCmd, cmd, std::min(cmdSize, sizeof(chunkCmd)));
+  uint32_t address = Address(cmd);
+  while (size > 0) {
+    size_t chunkSize = std::min(bufferSize, size);
+    chunkCmd[1] = address >> 16;
+    chunkCmd[2] = address >> 8;
+    chunkCmd[3] = address;
+    Execute(chunkCmd, cmdSize, nullptr, chunkSize, buffer);
+    if (onChunk != nullptr) {
+      onChunk(buffer, chunkSize);
+    }
+    address += chunkSize;
+    size -= chunkSize;
+  }
+  return true;
+}
+
+bool Spi::WriteCmdAndBuffer(const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize) {
+  Transaction(cmd, cmdSize, data, dataSize, nullptr);
+  return true;
+}
+
+void Spi::Sleep() {
+}
+
+void Spi::Wakeup() {
+}
+
+bool Spi::Busy() const {
+  return now < busyUntil;
+}
+
+void Spi::CutPowerAfter(uint64_t writes) {
+  writesBeforePowerLoss = writes;
+}
+
+void Spi::PowerOn() {
+  writesBeforePowerLoss = UINT64_MAX;
+  powerLost = false;
+  writeEnabled = false;
+  busyUntil = 0;
+}
+
+bool Spi::Interrupted() {
+  if (writesBeforePowerLoss == 0) {
+    powerLost = true;
+    return true;
+  }
+  writesBeforePowerLoss--;
+  return false;
+}
+
+// A byte takes 1us on the 8MHz bus
+void Spi::Account(size_t size) {
+  statistics.transactions++;
+  statistics.bytes += size;
+  Advance(transactionOverheadUs + size);
+}
+
+void Spi::Transaction(const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize, uint8_t* response) {
+  Account(cmdSize + dataSize);
+  Execute(cmd, cmdSize, data, dataSize, response);
+}
+
+void Spi::Execute(const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize, uint8_t* response) {
+  if (cmdSize == 0) {
+    return;
+  }
+
+  if (cmd[0] == 0x05) { // read status register
+    std::fill(response, response + dataSize, (Busy() ? 0x01 : 0x00) | (writeEnabled ? 0x02 : 0x00));
+    return;
+  }
+  if (Busy()) {
+    statistics.busyViolations++;
+    return;
+  }
+
+  switch (cmd[0]) {
+    case 0x03: // read
+    case 0x0B: // fast read, with a dummy byte after the address
+    {
+      uint32_t address = Address(cmd) % flashSize;
+      for (size_t i = 0; i < dataSize; i++) {
+        response[i] = memory[(address + i) % flashSize];
+      }
+      statistics.readBytes += dataSize;
+    } break;
+    case 0x02: // page program: programming only clears bits, and wraps around in the page
+    {
+      if (!writeEnabled || cmdSize < 4 || powerLost) {
+        break;
+      }
+      bool interrupted = Interrupted();
+      uint32_t address = Address(cmd) % flashSize;
+      uint32_t page = address & ~(pageSize - 1);
+      for (size_t i = 0; i < dataSize; i++) {
+        uint8_t& byte = memory[page + (address + i) % pageSize];
+        // 0xFF leaves a byte unchanged, SpiNorFlash sends it in the gaps between the writes it coalesced
+        if (data[i] != 0xFF && (data[i] & ~byte) != 0) {
+          statistics.setBitViolations++;
+        }
+        // An interrupted program clears some of the bits only
+        byte &= interrupted ? (data[i] | static_cast<uint8_t>(random())) : data[i];
+      }
+      statistics.pagePrograms++;
+      statistics.programmedBytes += dataSize;
+      writeEnabled = false;
+      busyUntil = now + pageProgramUs;
+    } break;
+    case 0x20: // sector erase
+    {
+      if (!writeEnabled || cmdSize < 4 || powerLost) {
+        break;
+      }
+      uint32_t sector = (Address(cmd) % flashSize) & ~(sectorSize - 1);
+      if (Interrupted()) {
+        // Some of the bits are set only
+        for (uint32_t i = 0; i < sectorSize; i++) {
+          memory[sector + i] |= static_cast<uint8_t>(random());
+        }
+      } else {
+        std::memset(memory.data() + sector, 0xFF, sectorSize);
+      }
+      statistics.sectorErases++;
+      writeEnabled = false;
+      busyUntil = now + sectorEraseUs;
+    } break;
+    case 0x06: // write enable
+      writeEnabled = true;
+      break;
+    case 0x9F: // JEDEC identification
+      for (size_t i = 0; i < dataSize; i++) {
+        response[i] = i < sizeof(identification) ? identification[i] : 0;
+      }
+      break;
+    case 0x2B: // security register: program and erase never fail
+    case 0x15: // configuration register
+    case 0xAB: // release from deep power down
+      std::fill(response, response + dataSize, 0);
+      break;
+    default:
+      break;
+  }
+}
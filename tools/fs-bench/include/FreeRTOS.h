@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// Host replacement for the FreeRTOS types used by FS and SpiNorFlash
+using TickType_t = uint32_t;
+using BaseType_t = long;
+#define configTICK_RATE_HZ 1024
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffffUL
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <random>
+#include <vector>
+#include <task.h> // included by the SpiMaster.h of the firmware
+
+namespace Pinetime {
+  namespace Drivers {
+    // Host replacement for the SPI bus of the external flash: an emulated SPI NOR flash (XT25F32B)
+    // that counts the transactions, and models the time they take on the 8MHz bus of the watch.
+    // Programs only clear bits. The power can be cut during a program or an erase, see CutPowerAfter().
+    class Spi {
+    public:
+      struct Statistics {
+        uint64_t transactions;
+        uint64_t bytes;         // on the bus, commands included
+        uint64_t readBytes;     // data bytes read from the memory
+        uint64_t pagePrograms;
+        uint64_t programmedBytes;
+        uint64_t sectorErases;
+        uint64_t busyViolations;   // commands sent while a program or erase was in progress
+        uint64_t setBitViolations; // bytes programmed with bits to set, which only an erase can do
+      };
+
+      static constexpr size_t flashSize = 4 * 1024 * 1024;
+      static constexpr uint32_t transactionOverheadUs = 10; // chip select, EasyDMA setup and task wake up
+      static constexpr uint32_t pageProgramUs = 600;
+      static constexpr uint32_t sectorEraseUs = 45000;
+
+      Spi();
+      Spi(const Spi&) = delete;
+      Spi& operator=(const Spi&) = delete;
+      Spi(Spi&&) = delete;
+      Spi& operator=(Spi&&) = delete;
+
+      bool Init();
+      bool Write(const uint8_t* data, size_t size, const std::function<void()>& preTransactionHook);
+      bool Read(uint8_t* cmd, size_t cmdSize, uint8_t* data, size_t dataSize);
+      bool ReadChunks(uint8_t* cmd,
+                      size_t cmdSize,
+                      uint8_t* buffer,
+                      size_t bufferSize,
+                      size_t size,
+                      const std::function<void(const uint8_t*, size_t)>& onChunk);
+      bool WriteCmdAndBuffer(const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize);
+      void Sleep();
+      void Wakeup();
+
+      const Statistics& GetStatistics() const {
+        return statistics;
+      }
+      // The violations are kept: they are errors of the firmware, not measures
+      void ResetStatistics() {
+        Statistics reset {};
+        reset.busyViolations = statistics.busyViolations;
+        reset.setBitViolations = statistics.setBitViolations;
+        statistics = reset;
+      }
+
+      // The program or erase command following the next writes programs and erases is interrupted: it only
+      // changes some of the bits. The following programs and erases are ignored, until PowerOn().
+      void CutPowerAfter(uint64_t writes);
+      // Restarts the flash, as after a reset. FS and SpiNorFlash must be created again.
+      void PowerOn();
+
+      bool PowerLost() const {
+        return powerLost;
+      }
+
+      // Emulated time, in us
+      static uint64_t Now();
+      static void Advance(uint64_t us);
+
+    private:
+      void Account(size_t size);
+      void Transaction(const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize, uint8_t* response);
+      void Execute(const uint8_t* cmd, size_t cmdSize, const uint8_t* data, size_t dataSize, uint8_t* response);
+      bool Busy() const;
+      // Counts a program or an erase, returns true if the power is cut during this one
+      bool Interrupted();
+
+      std::vector<uint8_t> memory;
+      Statistics statistics {};
+      bool writeEnabled = false;
+      uint64_t busyUntil = 0;
+      uint64_t writesBeforePowerLoss = UINT64_MAX;
+      bool powerLost = false;
+      std::minstd_rand random;
+    };
+  }
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace Pinetime {
+  namespace Drivers {
+    // Host replacement: the emulated flash has no bus to power down, FS::Sleep() is never given one
+    class SpiMaster {
+    public:
+      void Sleep() {
+      }
+
+      void Wakeup() {
+      }
+    };
+  }
+}
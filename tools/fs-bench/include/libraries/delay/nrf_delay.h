@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstdint>
+
+// Advances the emulated clock of the flash model, see drivers/Spi.h
+void nrf_delay_us(uint32_t us);
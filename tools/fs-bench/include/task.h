@@ -0,0 +1,7 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+// Delays advance the emulated clock of the flash model, see drivers/Spi.h
+TickType_t xTaskGetTickCount();
+void vTaskDelay(TickType_t ticks);
@@ -0,0 +1,238 @@
+// Measures the SPI traffic caused by the file accesses of the firmware, with the littlefs cache sizes
+// and the read-ahead this executable was built with (FS_CACHE_SIZE, FS_LOOKAHEAD_SIZE, FS_READ_AHEAD_SIZE).
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "components/fs/FS.h"
+#include "components/fs/KeyValueStore.h"
+#include "drivers/Spi.h"
+#include "drivers/SpiNorFlash.h"
+
+using namespace Pinetime;
+
+namespace {
+  struct Measure {
+    Drivers::Spi& spi;
+    const char* name;
+    size_t bytes = 0; // bytes read or written by the benchmark
+    uint64_t start = Drivers::Spi::Now();
+    // Done while the watch is idle, not accounted for
+    uint64_t idleTransactions = 0;
+    uint64_t idleBytes = 0;
+    uint64_t idleTime = 0;
+
+    Measure(Drivers::Spi& spi, const char* name) : spi {spi}, name {name} {
+      spi.ResetStatistics();
+    }
+
+    template <typename Function>
+    void Idle(Function function) {
+      auto before = spi.GetStatistics();
+      uint64_t idleStart = Drivers::Spi::Now();
+      function();
+      idleTransactions += spi.GetStatistics().transactions - before.transactions;
+      idleBytes += spi.GetStatistics().bytes - before.bytes;
+      idleTime += Drivers::Spi::Now() - idleStart;
+    }
+
+    ~Measure() {
+      const auto& stats = spi.GetStatistics();
+      double kb = bytes / 1024.0;
+      uint64_t time = Drivers::Spi::Now() - start - idleTime;
+      std::printf("%-24s %10.1f %12.1f %12.0f %10.2f\n",
+                  name,
+                  (stats.transactions - idleTransactions) / kb,
+                  (stats.bytes - idleBytes) / kb,
+                  time / kb,
+                  time / 1000.0);
+      if (idleTime > 0) {
+        std::printf("  %-22s %49.2f\n", "idle time", idleTime / 1000.0);
+      }
+    }
+  };
+
+  void WriteFile(Controllers::FS& fs, const char* path, const std::vector<uint8_t>& data) {
+    lfs_file_t file;
+    fs.FileOpen(&file, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    fs.FileWrite(&file, data.data(), data.size());
+    fs.FileClose(&file);
+  }
+
+  // As FSService does: the file is opened and closed for each chunk, and the free space is computed after each one
+  void Upload(Controllers::FS& fs, const char* path, const std::vector<uint8_t>& data) {
+    constexpr size_t chunkSize = 232; // ATT MTU of 247 bytes, minus the headers
+    lfs_file_t file;
+    if (fs.FileOpen(&file, path, LFS_O_RDWR | LFS_O_CREAT) == LFS_ERR_OK) {
+      fs.FileClose(&file);
+    }
+    fs.GetFSSize();
+    for (size_t offset = 0; offset < data.size(); offset += chunkSize) {
+      if (fs.FileOpen(&file, path, LFS_O_RDWR | LFS_O_CREAT) == LFS_ERR_OK) {
+        fs.FileSeek(&file, offset);
+        fs.FileWrite(&file, data.data() + offset, std::min(chunkSize, data.size() - offset));
+        fs.FileClose(&file);
+      }
+      fs.GetFSSize();
+    }
+  }
+
+  std::vector<uint8_t> RandomData(size_t size, std::mt19937& random) {
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) {
+      byte = random();
+    }
+    return data;
+  }
+}
+
+int main() {
+  Drivers::Spi spi;
+  Drivers::SpiNorFlash flash {spi};
+  flash.Init();
+  Controllers::FS fs {flash};
+  fs.Init();
+
+  std::mt19937 random {42};
+  constexpr size_t fontSize = 48 * 1024;
+  constexpr size_t settingsSize = 200;
+  WriteFile(fs, "/font.bin", RandomData(fontSize, random));
+  for (int i = 0; i < 8; i++) {
+    char path[16];
+    std::snprintf(path, sizeof(path), "/app%d.dat", i);
+    WriteFile(fs, path, RandomData(settingsSize, random));
+  }
+
+  std::printf("cache %d B, lookahead %d B, read-ahead %d B\n\n", FS_CACHE_SIZE, FS_LOOKAHEAD_SIZE, FS_READ_AHEAD_SIZE);
+  std::printf("%-24s %10s %12s %12s %10s\n", "Benchmark", "xfers/KB", "bus B/KB", "us/KB", "total ms");
+
+  std::vector<uint8_t> buffer(4096);
+  lfs_file_t file;
+  for (size_t chunk : {16, 64, 256}) {
+    char name[32];
+    // Fonts and images are loaded by LVGL in small reads
+    std::snprintf(name, sizeof(name), "font load, %zu B reads", chunk);
+    Measure measure {spi, name};
+    fs.FileOpen(&file, "/font.bin", LFS_O_RDONLY);
+    while (fs.FileRead(&file, buffer.data(), chunk) > 0) {
+      measure.bytes += chunk;
+    }
+    fs.FileClose(&file);
+  }
+
+  {
+    // Glyph lookups of a font loaded by LVGL: seek and read a few bytes
+    Measure measure {spi, "random 16 B reads"};
+    fs.FileOpen(&file, "/font.bin", LFS_O_RDONLY);
+    for (int i = 0; i < 1000; i++) {
+      fs.FileSeek(&file, random() % (fontSize - 16));
+      fs.FileRead(&file, buffer.data(), 16);
+      measure.bytes += 16;
+    }
+    fs.FileClose(&file);
+  }
+
+  {
+    // Settings files loaded by the applications when they start
+    Measure measure {spi, "open, read, close"};
+    for (int i = 0; i < 200; i++) {
+      char path[16];
+      std::snprintf(path, sizeof(path), "/app%d.dat", i % 8);
+      fs.FileOpen(&file, path, LFS_O_RDONLY);
+      measure.bytes += fs.FileRead(&file, buffer.data(), settingsSize);
+      fs.FileClose(&file);
+    }
+  }
+
+  {
+    // Settings saved as a file rewritten each time, as before the key-value store
+    Measure measure {spi, "settings, file"};
+    auto data = RandomData(settingsSize, random);
+    for (int i = 0; i < 100; i++) {
+      data[i % settingsSize]++;
+      WriteFile(fs, "/settings.dat", data);
+      measure.bytes += data.size();
+    }
+  }
+
+  {
+    // Settings saved in the key-value store: only the slices that changed are written
+    Measure measure {spi, "settings, store"};
+    Controllers::KeyValueStore store {fs};
+    auto data = RandomData(settingsSize, random);
+    for (int i = 0; i < 100; i++) {
+      data[i % settingsSize]++;
+      store.Set(Controllers::KeyValueStore::Key::Settings, data.data(), data.size());
+      measure.bytes += data.size();
+    }
+  }
+
+  {
+    Measure measure {spi, "FSService 32 KB write"};
+    auto data = RandomData(32 * 1024, random);
+    Upload(fs, "/upload.bin", data);
+    measure.bytes += data.size();
+  }
+
+  {
+    // The resources of the companion app: a few fonts and images, in their directories
+    Measure measure {spi, "resource upload"};
+    fs.DirCreate("/fonts");
+    fs.DirCreate("/images");
+    for (size_t size : {24 * 1024, 40 * 1024, 12 * 1024}) {
+      char path[32];
+      std::snprintf(path, sizeof(path), "/fonts/font%zu.bin", size / 1024);
+      auto data = RandomData(size, random);
+      Upload(fs, path, data);
+      measure.bytes += data.size();
+    }
+    for (int i = 0; i < 10; i++) {
+      char path[32];
+      std::snprintf(path, sizeof(path), "/images/image%d.bin", i);
+      auto data = RandomData(6 * 1024, random);
+      Upload(fs, path, data);
+      measure.bytes += data.size();
+    }
+  }
+
+  {
+    Measure measure {spi, "rewrite 4 KB"};
+    for (int i = 0; i < 10; i++) {
+      auto data = RandomData(4096, random);
+      WriteFile(fs, "/log.dat", data);
+      measure.bytes += data.size();
+    }
+  }
+
+  {
+    // Same writes, with the free blocks erased beforehand as when the watch goes to sleep
+    Measure measure {spi, "rewrite 4 KB, pre-erased"};
+    for (int i = 0; i < 10; i++) {
+      measure.Idle([&fs]() {
+        while (fs.PreErase()) {
+        }
+      });
+      auto data = RandomData(4096, random);
+      WriteFile(fs, "/log.dat", data);
+      measure.bytes += data.size();
+    }
+  }
+
+  auto stats = fs.GetStatistics();
+  std::printf("\nFile cache: %u hits, %u misses\n", stats.cacheHits, stats.cacheMisses);
+  std::printf("Block device reads: %u from the flash, %u from the read-ahead buffer\n", stats.flashReads, stats.readAheadHits);
+  std::printf("Erases: %u done ahead of time, %u skipped by littlefs\n", stats.preErases, stats.erasesSkipped);
+  if (spi.GetStatistics().busyViolations > 0) {
+    std::printf("Error: %llu commands sent while the flash was busy\n",
+                static_cast<unsigned long long>(spi.GetStatistics().busyViolations));
+    return 1;
+  }
+  if (spi.GetStatistics().setBitViolations > 0) {
+    std::printf("Error: %llu bytes programmed over cleared bits\n",
+                static_cast<unsigned long long>(spi.GetStatistics().setBitViolations));
+    return 1;
+  }
+  return 0;
+}
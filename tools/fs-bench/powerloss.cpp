@@ -0,0 +1,160 @@
+// Cuts the power of the emulated flash during each program and erase of a workload: saving the settings in the
+// key-value store, erasing the free blocks ahead of time as when the watch goes to sleep, then uploading a file in
+// chunks like FSService, into the blocks erased beforehand. After each cut, the file system is mounted again
+// and checked: it must not have been formatted, the settings must be the old or the new ones, the uploaded file must
+// be a prefix of the uploaded data, and files must still be writable.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "components/fs/FS.h"
+#include "components/fs/KeyValueStore.h"
+#include "drivers/Spi.h"
+#include "drivers/SpiNorFlash.h"
+
+using namespace Pinetime;
+
+namespace {
+  constexpr size_t settingsSize = 200;
+  constexpr size_t uploadSize = 8 * 1024;
+  constexpr size_t chunkSize = 232;
+  constexpr const char* markerPath = "/marker.dat";
+  constexpr const char* uploadPath = "/upload.bin";
+  constexpr const char* checkPath = "/check.dat";
+
+  // The flash driver and the file system, created again after each power cut as on boot
+  struct Watch {
+    Drivers::SpiNorFlash flash;
+    Controllers::FS fs;
+
+    explicit Watch(Drivers::Spi& spi) : flash {spi}, fs {flash} {
+      flash.Init();
+      fs.Init();
+    }
+  };
+
+  std::vector<uint8_t> Data(size_t size, uint32_t seed) {
+    std::mt19937 random {seed};
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) {
+      byte = random();
+    }
+    return data;
+  }
+
+  void WriteFile(Controllers::FS& fs, const char* path, const std::vector<uint8_t>& data) {
+    lfs_file_t file;
+    fs.FileOpen(&file, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    fs.FileWrite(&file, data.data(), data.size());
+    fs.FileClose(&file);
+  }
+
+  // Returns the size of the file, -1 if it can't be read
+  int ReadFile(Controllers::FS& fs, const char* path, std::vector<uint8_t>& data) {
+    lfs_file_t file;
+    if (fs.FileOpen(&file, path, LFS_O_RDONLY) != LFS_ERR_OK) {
+      return -1;
+    }
+    int size = fs.FileRead(&file, data.data(), data.size());
+    fs.FileClose(&file);
+    return size;
+  }
+
+  void Setup(Drivers::Spi& spi) {
+    Watch watch {spi};
+    WriteFile(watch.fs, markerPath, Data(100, 0));
+    Controllers::KeyValueStore store {watch.fs};
+    auto settings = Data(settingsSize, 1);
+    store.Set(Controllers::KeyValueStore::Key::Settings, settings.data(), settings.size());
+  }
+
+  // Stops at the power cut: what the firmware does afterwards never reaches the flash
+  void Workload(Drivers::Spi& spi) {
+    Watch watch {spi};
+    Controllers::KeyValueStore store {watch.fs};
+    auto settings = Data(settingsSize, 2);
+    store.Set(Controllers::KeyValueStore::Key::Settings, settings.data(), settings.size());
+
+    while (!spi.PowerLost() && watch.fs.PreErase()) {
+    }
+
+    auto data = Data(uploadSize, 3);
+    lfs_file_t file;
+    for (size_t offset = 0; offset < data.size() && !spi.PowerLost(); offset += chunkSize) {
+      if (watch.fs.FileOpen(&file, uploadPath, LFS_O_RDWR | LFS_O_CREAT) == LFS_ERR_OK) {
+        watch.fs.FileSeek(&file, offset);
+        watch.fs.FileWrite(&file, data.data() + offset, std::min(chunkSize, data.size() - offset));
+        watch.fs.FileClose(&file);
+      }
+    }
+  }
+
+  // Returns the error found, nullptr if there is none
+  const char* Check(Drivers::Spi& spi) {
+    Watch watch {spi};
+    std::vector<uint8_t> buffer(uploadSize);
+
+    auto marker = Data(100, 0);
+    if (ReadFile(watch.fs, markerPath, buffer) != static_cast<int>(marker.size()) ||
+        !std::equal(marker.begin(), marker.end(), buffer.begin())) {
+      return "formatted or marker file lost";
+    }
+
+    Controllers::KeyValueStore store {watch.fs};
+    auto oldSettings = Data(settingsSize, 1);
+    auto newSettings = Data(settingsSize, 2);
+    if (store.Get(Controllers::KeyValueStore::Key::Settings, buffer.data(), buffer.size()) != static_cast<int>(settingsSize) ||
+        (!std::equal(oldSettings.begin(), oldSettings.end(), buffer.begin()) &&
+         !std::equal(newSettings.begin(), newSettings.end(), buffer.begin()))) {
+      return "settings lost or mixed";
+    }
+
+    auto upload = Data(uploadSize, 3);
+    int size = ReadFile(watch.fs, uploadPath, buffer);
+    if (size > 0 && !std::equal(buffer.begin(), buffer.begin() + size, upload.begin())) {
+      return "uploaded file corrupted";
+    }
+
+    auto check = Data(1000, 4);
+    WriteFile(watch.fs, checkPath, check);
+    if (ReadFile(watch.fs, checkPath, buffer) != static_cast<int>(check.size()) ||
+        !std::equal(check.begin(), check.end(), buffer.begin())) {
+      return "file system not writable";
+    }
+    return nullptr;
+  }
+
+  uint64_t Writes(const Drivers::Spi& spi) {
+    return spi.GetStatistics().pagePrograms + spi.GetStatistics().sectorErases;
+  }
+}
+
+int main() {
+  uint64_t writes;
+  {
+    Drivers::Spi spi;
+    Setup(spi);
+    uint64_t before = Writes(spi);
+    Workload(spi);
+    writes = Writes(spi) - before;
+  }
+  std::printf("Workload: %llu programs and erases\n", static_cast<unsigned long long>(writes));
+
+  int failures = 0;
+  for (uint64_t cut = 0; cut < writes; cut++) {
+    Drivers::Spi spi;
+    Setup(spi);
+    spi.CutPowerAfter(cut);
+    Workload(spi);
+    spi.PowerOn();
+    const char* error = Check(spi);
+    if (error != nullptr) {
+      std::printf("Power cut during write %llu: %s\n", static_cast<unsigned long long>(cut), error);
+      failures++;
+    }
+  }
+  std::printf("%llu power cuts, %d failures\n", static_cast<unsigned long long>(writes), failures);
+  return failures > 0 ? 1 : 0;
+}
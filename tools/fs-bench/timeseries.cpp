@@ -0,0 +1,120 @@
+// Measures the cost of saving heart rate samples with TimeSeries: appending a day of samples with different sync
+// periods, compared to opening and closing a file for each sample, and querying time ranges.
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "components/fs/FS.h"
+#include "components/fs/TimeSeries.h"
+#include "drivers/Spi.h"
+#include "drivers/SpiNorFlash.h"
+
+using namespace Pinetime;
+
+namespace {
+  constexpr uint32_t start = 1700000000;
+  constexpr uint32_t period = 10; // s between samples
+  constexpr size_t samplesPerDay = 24 * 3600 / period;
+
+  struct Result {
+    uint64_t time;
+    Drivers::Spi::Statistics stats;
+  };
+
+  template <typename Function>
+  Result Run(Drivers::Spi& spi, Function function) {
+    spi.ResetStatistics();
+    uint64_t begin = Drivers::Spi::Now();
+    function();
+    return {Drivers::Spi::Now() - begin, spi.GetStatistics()};
+  }
+
+  void PrintAppend(const char* name, const Result& result, size_t samples) {
+    std::printf("%-28s %10.1f %12.1f %12.2f %10.2f\n",
+                name,
+                static_cast<double>(result.time) / samples,
+                static_cast<double>(result.stats.programmedBytes) / samples,
+                result.stats.sectorErases * 1000.0 / samples,
+                result.time / 1000.0);
+  }
+
+  void PrintQuery(const char* name, const Result& result, int samples) {
+    std::printf("%-28s %10d %12llu %12llu %10.2f\n",
+                name,
+                samples,
+                static_cast<unsigned long long>(result.stats.transactions),
+                static_cast<unsigned long long>(result.stats.readBytes),
+                result.time / 1000.0);
+  }
+
+  // One day of samples, synced every syncPeriod samples
+  Result AppendDay(Drivers::Spi& spi, Controllers::TimeSeries& series, uint32_t day, size_t syncPeriod) {
+    return Run(spi, [&]() {
+      for (size_t i = 0; i < samplesPerDay; i++) {
+        series.Append(start + day * 24 * 3600 + i * period, 60 + i % 60);
+        if ((i + 1) % syncPeriod == 0) {
+          series.Sync();
+        }
+      }
+      series.Sync();
+    });
+  }
+}
+
+int main() {
+  Drivers::Spi spi;
+  Drivers::SpiNorFlash flash {spi};
+  flash.Init();
+  Controllers::FS fs {flash};
+  fs.Init();
+
+  std::printf("%zu samples per day, 1 byte values\n\n", samplesPerDay);
+  std::printf("%-28s %10s %12s %12s %10s\n", "Append", "us/sample", "prog B/smpl", "erases/1000", "total ms");
+
+  Controllers::TimeSeries series {fs, "bench", 1, Controllers::TimeSeries::maxSegments};
+  series.Init();
+  PrintAppend("sync at segment end", AppendDay(spi, series, 0, samplesPerDay), samplesPerDay);
+  PrintAppend("sync every 10 minutes", AppendDay(spi, series, 1, 600 / period), samplesPerDay);
+  PrintAppend("sync every minute", AppendDay(spi, series, 2, 60 / period), samplesPerDay);
+
+  // The naive way: the sample is appended to a file opened and closed each time
+  auto naive = Run(spi, [&]() {
+    lfs_file_t file;
+    for (size_t i = 0; i < samplesPerDay; i++) {
+      uint32_t timestamp = start + i * period;
+      uint8_t record[5] = {0, 0, 0, 0, static_cast<uint8_t>(60 + i % 60)};
+      std::memcpy(record, &timestamp, sizeof(timestamp));
+      fs.FileOpen(&file, "/naive.dat", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND);
+      fs.FileWrite(&file, record, sizeof(record));
+      fs.FileClose(&file);
+    }
+  });
+  PrintAppend("open, append, close", naive, samplesPerDay);
+
+  std::printf("\n%zu segments of %zu samples\n\n", series.Segments(), series.SamplesPerSegment());
+  std::printf("%-28s %10s %12s %12s %10s\n", "Query", "samples", "xfers", "read B", "ms");
+  std::vector<Controllers::TimeSeries::Sample> samples(3 * samplesPerDay);
+  int count = 0;
+  auto hour = Run(spi, [&]() {
+    count = series.Query(start + 24 * 3600 + 12 * 3600, start + 24 * 3600 + 13 * 3600 - 1, samples.data(), samples.size());
+  });
+  PrintQuery("one hour", hour, count);
+  auto last = Run(spi, [&]() {
+    count = series.Query(start + 3 * 24 * 3600 - 300, start + 3 * 24 * 3600, samples.data(), samples.size());
+  });
+  PrintQuery("last 5 minutes", last, count);
+  auto all = Run(spi, [&]() {
+    count = series.Query(start, start + 3 * 24 * 3600, samples.data(), samples.size());
+  });
+  PrintQuery("three days", all, count);
+
+  if (spi.GetStatistics().busyViolations > 0) {
+    std::printf("Error: commands sent while the flash was busy\n");
+    return 1;
+  }
+  if (spi.GetStatistics().setBitViolations > 0) {
+    std::printf("Error: bytes programmed over cleared bits\n");
+    return 1;
+  }
+  return 0;
+}
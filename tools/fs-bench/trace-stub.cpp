@@ -0,0 +1,13 @@
+#include "utility/FlashTelemetry.h"
+#include "utility/Trace.h"
+
+// The event trace and the flash telemetry are not recorded on the host
+void Pinetime::Utility::Trace::Record(Event, uint32_t) {
+}
+
+uint32_t Pinetime::Utility::FlashTelemetry::Start() {
+  return 0;
+}
+
+void Pinetime::Utility::FlashTelemetry::Record(Operation, uint32_t, uint32_t) {
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+
+// Host replacement for the FreeRTOS types used by MotionController
+using TickType_t = uint32_t;
+#define configTICK_RATE_HZ 1024
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <FreeRTOS.h>
+
+// Host replacement for the BLE motion service, which MotionController notifies of new values
+namespace Pinetime {
+  namespace Controllers {
+    class MotionService {
+    public:
+      void OnNewStepCountValue(uint32_t /*stepCount*/) {
+      }
+
+      void OnNewMotionValues(int16_t /*x*/, int16_t /*y*/, int16_t /*z*/, TickType_t /*timestamp*/) {
+      }
+    };
+  }
+}
@@ -0,0 +1,118 @@
+// Measures the host CPU time spent by MotionController per accelerometer sample, on a synthetic
+// stream of wrist rolls, and checks Utility::Asin against the C library.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "components/motion/MotionController.h"
+#include "utility/Math.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+  #define HAVE_TSC 1
+#endif
+
+namespace {
+  struct Sample {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+  };
+
+  constexpr double pi = 3.14159265358979323846;
+  // 1g, in the units of MotionController
+  constexpr double gravity = 1024;
+
+  // Roll angle during each 8s cycle: the wrist is quickly rolled towards the face (0.5s), held, and rolled back
+  double Roll(double phase) {
+    constexpr double rollDuration = 0.0625;
+    if (phase < 0.5) {
+      return 0;
+    }
+    if (phase < 0.5 + rollDuration) {
+      return (phase - 0.5) / rollDuration * pi / 2;
+    }
+    if (phase < 0.9) {
+      return pi / 2;
+    }
+    if (phase < 0.9 + rollDuration) {
+      return (0.9 + rollDuration - phase) / rollDuration * pi / 2;
+    }
+    return 0;
+  }
+
+  // Wrist gestures sampled at 12.5Hz, with some noise
+  std::vector<Sample> GenerateStream(size_t count) {
+    std::vector<Sample> samples;
+    samples.reserve(count);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < count; i++) {
+      double phase = static_cast<double>(i % 100) / 100;
+      double roll = Roll(phase);
+      seed = seed * 1103515245 + 12345;
+      double noise = static_cast<double>((seed >> 16) % 41) - 20;
+      samples.push_back({static_cast<int16_t>(noise),
+                         static_cast<int16_t>(-std::sin(roll) * gravity + noise),
+                         static_cast<int16_t>(-std::cos(roll) * gravity + noise)});
+    }
+    return samples;
+  }
+
+  int CheckAsin() {
+    int maxError = 0;
+    for (int32_t arg = -32767; arg <= 32767; arg++) {
+      auto expected = static_cast<int>(std::lround(std::asin(arg / 32767.0) * 180 / pi));
+      maxError = std::max(maxError, std::abs(Pinetime::Utility::Asin(static_cast<int16_t>(arg)) - expected));
+    }
+    std::printf("Asin: max error %d degree(s) over all the arguments\n", maxError);
+    return maxError <= 1 ? 0 : 1;
+  }
+}
+
+int main(int argc, char** argv) {
+  size_t count = 1000000;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+      count = std::strtoul(argv[++i], nullptr, 10);
+    } else {
+      std::fprintf(stderr, "Usage: %s [--samples count]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (CheckAsin() != 0) {
+    return 1;
+  }
+
+  auto samples = GenerateStream(count);
+  Pinetime::Controllers::MotionController motionController;
+  size_t raiseGestures = 0;
+  size_t lowerGestures = 0;
+  TickType_t timestamp = 0;
+  constexpr TickType_t samplePeriod = 80 * configTICK_RATE_HZ / 1000;
+
+  auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_TSC
+  uint64_t startCycles = __rdtsc();
+#endif
+  for (const auto& sample : samples) {
+    timestamp += samplePeriod;
+    motionController.Update(sample.x, sample.y, sample.z, 0, timestamp);
+    // SystemTask evaluates the wake and sleep gestures after every sample
+    raiseGestures += motionController.ShouldRaiseWake() ? 1 : 0;
+    lowerGestures += motionController.ShouldLowerSleep() ? 1 : 0;
+  }
+#ifdef HAVE_TSC
+  uint64_t cycles = __rdtsc() - startCycles;
+#endif
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+  std::printf("%zu samples, %zu raise gestures, %zu lower gestures\n", samples.size(), raiseGestures, lowerGestures);
+  std::printf("Update + gesture checks: %.1f ns per sample", static_cast<double>(elapsed) / samples.size());
+#ifdef HAVE_TSC
+  std::printf(", %.1f TSC cycles per sample", static_cast<double>(cycles) / samples.size());
+#endif
+  std::printf("\n");
+  return 0;
+}
@@ -0,0 +1,163 @@
+// Replays a night of accelerometer samples through MotionController and the actigraphy scoring, and reports
+// the host CPU time spent per night. Without input, a synthetic night is generated.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "components/motion/Actigraphy.h"
+#include "components/motion/MotionController.h"
+
+namespace {
+  struct Sample {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+  };
+
+  constexpr double pi = 3.14159265358979323846;
+  constexpr double gravity = 1024;
+  // FIFO rate
+  constexpr uint32_t sampleRate = 12;
+  constexpr uint32_t samplesPerEpoch = sampleRate * Pinetime::Controllers::Actigraphy::epochDuration;
+  // The any-motion interrupt then enables the FIFO for 3s, see SystemTask
+  constexpr int anyMotionThreshold = 64;
+  constexpr uint32_t motionSamplingSamples = 3 * sampleRate;
+
+  class Generator {
+  public:
+    Sample Next(double pitch, double roll, double noiseAmplitude) {
+      seed = seed * 1103515245 + 12345;
+      double noise = (static_cast<double>((seed >> 16) % 2001) / 1000 - 1) * noiseAmplitude;
+      return {static_cast<int16_t>(std::sin(pitch) * gravity + noise),
+              static_cast<int16_t>(-std::sin(roll) * std::cos(pitch) * gravity + noise),
+              static_cast<int16_t>(-std::cos(roll) * std::cos(pitch) * gravity + noise)};
+    }
+
+    double Random() {
+      seed = seed * 1103515245 + 12345;
+      return static_cast<double>((seed >> 16) % 10000) / 10000;
+    }
+
+  private:
+    uint32_t seed = 1;
+  };
+
+  // 8 hours: awake 20 minutes, asleep with a few position changes and twitches, awake 5 minutes at 3h, awake the last 30 minutes
+  std::vector<Sample> GenerateNight() {
+    constexpr uint32_t minute = 60 * sampleRate;
+    constexpr uint32_t duration = 8 * 60 * minute;
+    Generator generator;
+    std::vector<Sample> samples;
+    samples.reserve(duration);
+    double roll = 0;
+    for (uint32_t i = 0; i < duration; i++) {
+      bool awake = i < 20 * minute || (i >= 180 * minute && i < 185 * minute) || i >= duration - 30 * minute;
+      if (awake) {
+        double t = static_cast<double>(i) / sampleRate;
+        samples.push_back(generator.Next(0.6 * std::sin(t * 0.7), 0.8 * std::sin(t * 1.3), 150));
+        continue;
+      }
+      if (i % (40 * minute) == 0) {
+        // Turning over
+        double target = generator.Random() * pi - pi / 2;
+        for (uint32_t j = 0; j < 3 * sampleRate && i < duration; j++, i++) {
+          samples.push_back(generator.Next(0, roll + (target - roll) * j / (3 * sampleRate), 200));
+        }
+        roll = target;
+      }
+      bool twitch = i % (10 * minute) < sampleRate;
+      samples.push_back(generator.Next(0, roll, twitch ? 120 : 4));
+    }
+    return samples;
+  }
+
+  bool ReadCsv(const char* path, std::vector<Sample>& samples) {
+    FILE* file = std::fopen(path, "r");
+    if (file == nullptr) {
+      return false;
+    }
+    int x;
+    int y;
+    int z;
+    while (std::fscanf(file, "%d,%d,%d", &x, &y, &z) == 3) {
+      samples.push_back({static_cast<int16_t>(x), static_cast<int16_t>(y), static_cast<int16_t>(z)});
+    }
+    std::fclose(file);
+    return true;
+  }
+}
+
+int main(int argc, char** argv) {
+  std::vector<Sample> samples;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+      if (!ReadCsv(argv[++i], samples)) {
+        std::fprintf(stderr, "Can't read %s\n", argv[i]);
+        return 1;
+      }
+    } else {
+      std::fprintf(stderr, "Usage: %s [--csv file]\nThe file has one x,y,z sample per line, at %u Hz, 1g = 1024\n", argv[0], sampleRate);
+      return 2;
+    }
+  }
+  if (samples.empty()) {
+    samples = GenerateNight();
+  }
+
+  Pinetime::Controllers::MotionController motionController;
+  Pinetime::Controllers::Actigraphy actigraphy;
+  std::vector<Pinetime::Controllers::Actigraphy::Epoch> epochs;
+  TickType_t timestamp = 0;
+  uint32_t processed = 0;
+  uint32_t samplingLeft = 0;
+  Sample previous = samples.front();
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < samples.size(); i++) {
+    const auto& sample = samples[i];
+    timestamp += configTICK_RATE_HZ / sampleRate;
+    // While asleep, the firmware only reads samples after an any-motion interrupt
+    if (std::abs(sample.x - previous.x) + std::abs(sample.y - previous.y) + std::abs(sample.z - previous.z) > anyMotionThreshold) {
+      samplingLeft = motionSamplingSamples;
+    }
+    previous = sample;
+    if (samplingLeft > 0) {
+      samplingLeft--;
+      motionController.Update(sample.x, sample.y, sample.z, 0, timestamp);
+      processed++;
+    }
+    if ((i + 1) % samplesPerEpoch == 0) {
+      uint32_t counts = motionController.ConsumeActigraphyCounts() / Pinetime::Controllers::Actigraphy::countsDivisor;
+      Pinetime::Controllers::Actigraphy::Epoch epoch;
+      if (actigraphy.Push(std::min<uint32_t>(counts, UINT16_MAX), epoch)) {
+        epochs.push_back(epoch);
+      }
+    }
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+  uint32_t awakeEpochs = 0;
+  std::printf("Hypnogram, one character per 5 minutes (# awake, . asleep):\n");
+  for (size_t i = 0; i < epochs.size(); i++) {
+    awakeEpochs += epochs[i].awake ? 1 : 0;
+    if (i % 10 == 9) {
+      bool awake = false;
+      for (size_t j = i - 9; j <= i; j++) {
+        awake |= epochs[j].awake;
+      }
+      std::printf("%c", awake ? '#' : '.');
+    }
+  }
+  std::printf("\n%zu samples, %u processed (%.1f%%), %zu epochs, %u awake\n",
+              samples.size(),
+              processed,
+              100.0 * processed / samples.size(),
+              epochs.size(),
+              awakeEpochs);
+  std::printf("CPU time: %.3f ms for the night, %.1f ns per processed sample\n",
+              elapsed / 1000.0,
+              processed > 0 ? elapsed * 1000.0 / processed : 0.0);
+  return 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// Host replacement for the nRF SDK logger
+#define NRF_LOG_INFO(...)
+#define NRF_LOG_WARNING(...)
+#define NRF_LOG_ERROR(...)
+#define NRF_LOG_DEBUG(...)
@@ -0,0 +1,300 @@
+// Replays raw PPG captures (see components/heartrate/PpgCapture.h) through the unchanged Ppg class
+// and reports, for every capture session, the heart rate estimates, the latency to the first value
+// and the host time spent per estimate.
+// With --battery, it compares the sensor usage of a day of background measurements with the fixed interval
+// policy and with HeartRateScheduler.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include "components/heartrate/HeartRateScheduler.h"
+#include "components/heartrate/Ppg.h"
+#include "components/heartrate/PpgCaptureFormat.h"
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  struct Session {
+    PpgCaptureFormat::SessionHeader header;
+    std::vector<PpgCaptureFormat::Sample> samples;
+  };
+
+  std::vector<Session> ReadCapture(const char* path) {
+    std::vector<Session> sessions;
+    std::ifstream file(path, std::ios::binary);
+    uint16_t marker;
+    while (file.read(reinterpret_cast<char*>(&marker), sizeof(marker))) {
+      if (marker == PpgCaptureFormat::sessionMarker) {
+        Session session;
+        session.header.marker = marker;
+        if (!file.read(reinterpret_cast<char*>(&session.header) + sizeof(marker), sizeof(session.header) - sizeof(marker))) {
+          break;
+        }
+        sessions.push_back(session);
+        continue;
+      }
+      PpgCaptureFormat::Sample sample;
+      sample.delta = marker;
+      if (!file.read(reinterpret_cast<char*>(&sample) + sizeof(marker), sizeof(sample) - sizeof(marker))) {
+        break;
+      }
+      if (sessions.empty()) {
+        fprintf(stderr, "Sample found before the first session header, ignoring\n");
+        continue;
+      }
+      sessions.back().samples.push_back(sample);
+    }
+    return sessions;
+  }
+
+  // Same computation as HeartRateTask (Utility::Sqrt rounds down)
+  uint16_t AccelerationMagnitude(int16_t x, int16_t y, int16_t z) {
+    return static_cast<uint16_t>(std::sqrt(static_cast<double>(x * x + y * y + z * z)));
+  }
+
+  void Replay(size_t index, const Session& session, bool csv) {
+    // Ppg is large, keep it off the stack like in HeartRateTask
+    static Ppg ppg;
+    ppg.Reset(true);
+
+    uint32_t time = 0;
+    int firstValueTime = -1;
+    int lastBpm = 0;
+    unsigned estimates = 0;
+    std::chrono::nanoseconds estimateTime {0};
+    std::chrono::nanoseconds maxEstimateTime {0};
+
+    for (const auto& sample : session.samples) {
+      time += sample.delta;
+      int8_t ambient = ppg.Preprocess(sample.hrs, sample.als, AccelerationMagnitude(sample.x, sample.y, sample.z));
+
+      auto start = std::chrono::steady_clock::now();
+      int bpm = ppg.HeartRate();
+      auto duration = std::chrono::steady_clock::now() - start;
+
+      // -2 and 0 are returned without running the spectral analysis
+      if (bpm != -2 && bpm != 0) {
+        estimates++;
+        estimateTime += duration;
+        if (duration > maxEstimateTime) {
+          maxEstimateTime = duration;
+        }
+        if (csv) {
+          printf("%zu,%u,%d,%u,%d\n", index, time, bpm, ppg.Confidence(), ppg.MotionDetected() ? 1 : 0);
+        }
+      }
+
+      // Same reactions as HeartRateTask
+      if (ambient > 0) {
+        ppg.Reset(true);
+        bpm = 0;
+      }
+      if (bpm == -1) {
+        ppg.Reset(false);
+        bpm = 0;
+      }
+      if (bpm > 0) {
+        lastBpm = bpm;
+        if (firstValueTime < 0) {
+          firstValueTime = static_cast<int>(time);
+        }
+      }
+    }
+
+    if (csv) {
+      return;
+    }
+    printf("Session %zu (t=%u ms, period %u ms): %zu samples, %u ms\n",
+           index,
+           session.header.timestamp,
+           session.header.deltaTms,
+           session.samples.size(),
+           time);
+    if (firstValueTime >= 0) {
+      printf("  first value after %d ms, last value %d BPM\n", firstValueTime, lastBpm);
+    } else {
+      printf("  no value\n");
+    }
+    if (estimates > 0) {
+      printf("  %u estimates, %lld ns average, %lld ns max (host)\n",
+             estimates,
+             static_cast<long long>(estimateTime.count() / estimates),
+             static_cast<long long>(maxEstimateTime.count()));
+    }
+  }
+  // Same limit as HeartRateTask: a background measurement that has no value after 30 s fails
+  constexpr uint32_t measurementTimeLimit = 30 * 1000;
+  // HeartRateTask::StartMeasurement() waits 100 ms after enabling the sensor before the first sample
+  constexpr uint32_t sensorStartTime = 100;
+  constexpr uint64_t day = 24 * 60 * 60 * 1000;
+  // Every profile converts at 15 bits, about 50 ms of each 100 ms sample: the LED is driven half of the time
+  constexpr double ledDutyCycle = 0.5;
+
+  // LED current of the profile HeartRateTask::ApplyDriveLevel() selects for each drive level, in mA
+  double LedCurrent(HeartRateScheduler::DriveLevels level) {
+    switch (level) {
+      case HeartRateScheduler::DriveLevels::Baseline:
+      case HeartRateScheduler::DriveLevels::Boosted:
+        return 12.5;
+      case HeartRateScheduler::DriveLevels::Maximum:
+        return 20;
+    }
+    return 20;
+  }
+
+  // Feeds a sample to ppg, with the same reactions as HeartRateTask to ambient light and to reset requests.
+  // Returns the estimate, or 0 when there is none.
+  int Process(Ppg& ppg, const PpgCaptureFormat::Sample& sample) {
+    int8_t ambient = ppg.Preprocess(sample.hrs, sample.als, AccelerationMagnitude(sample.x, sample.y, sample.z));
+    int bpm = ppg.HeartRate();
+    if (ambient > 0) {
+      ppg.Reset(true);
+      return 0;
+    }
+    if (bpm == -1) {
+      ppg.Reset(false);
+      return 0;
+    }
+    return bpm > 0 ? bpm : 0;
+  }
+
+  struct Measurement {
+    uint32_t duration; // ms, from the first sample
+    bool succeeded;
+    // The session ended before the measurement: it is counted as a failure that reached the time limit
+    bool truncated;
+  };
+
+  // Replays a session as a background measurement, until isDone(bpm, ppg) returns true or the time limit is reached.
+  // Ppg is large, keep it off the stack like in HeartRateTask.
+  template <class IsDone>
+  Measurement Measure(const Session& session, IsDone&& isDone) {
+    static Ppg ppg;
+    ppg.Reset(true);
+    uint32_t time = 0;
+    for (const auto& sample : session.samples) {
+      time += sample.delta;
+      if (time > measurementTimeLimit) {
+        return {time, false, false};
+      }
+      int bpm = Process(ppg, sample);
+      if (bpm != 0 && isDone(bpm, ppg)) {
+        return {time, true, false};
+      }
+    }
+    return {measurementTimeLimit, false, true};
+  }
+
+  struct DayUsage {
+    unsigned measurements = 0;
+    unsigned failures = 0;
+    unsigned truncated = 0;
+    double sensorOnTime = 0; // s
+    double ledOnTime = 0;    // s
+    double charge = 0;       // mAs
+  };
+
+  // Runs background measurements for a day, taking the recorded sessions in turn as their signal.
+  // The fixed policy (the one before HeartRateScheduler) stops at the first value and waits baseInterval.
+  // The sensor keeps the drive level of the recording: only the LED current accounted for changes.
+  DayUsage SimulateDay(const std::vector<const Session*>& sessions, uint32_t baseInterval, bool adaptive) {
+    HeartRateScheduler scheduler;
+    DayUsage usage;
+    uint64_t time = 0;
+    for (size_t i = 0; time < day; i++) {
+      auto level = adaptive ? scheduler.DriveLevel() : HeartRateScheduler::DriveLevels::Baseline;
+      scheduler.StartMeasurement();
+      Measurement measurement = Measure(*sessions[i % sessions.size()], [&](int bpm, const Ppg& ppg) {
+        return !adaptive || scheduler.OnEstimate(bpm, ppg.Confidence(), ppg.MotionDetected());
+      });
+      scheduler.OnMeasurementDone(measurement.succeeded);
+
+      double onTime = (sensorStartTime + measurement.duration) / 1000.0;
+      usage.measurements++;
+      usage.failures += measurement.succeeded ? 0 : 1;
+      usage.truncated += measurement.truncated ? 1 : 0;
+      usage.sensorOnTime += onTime;
+      usage.ledOnTime += onTime * ledDutyCycle;
+      usage.charge += onTime * ledDutyCycle * LedCurrent(level);
+
+      // Shortened intervals never go below the measurement time limit, as in HeartRateTask
+      uint32_t interval = adaptive ? std::max(scheduler.NextInterval(baseInterval), std::min(baseInterval, measurementTimeLimit)) : baseInterval;
+      time += std::max<uint64_t>(interval, sensorStartTime + measurement.duration);
+    }
+    return usage;
+  }
+
+  void PrintUsage(const char* policy, const DayUsage& usage) {
+    printf("%-10s %5u measurements, %4u failed (%u truncated), sensor on %6.0f s, LED on %6.0f s, %.2f mAh per day\n",
+           policy,
+           usage.measurements,
+           usage.failures,
+           usage.truncated,
+           usage.sensorOnTime,
+           usage.ledOnTime,
+           usage.charge / 3600);
+  }
+
+  void CompareBattery(const std::vector<const Session*>& sessions, uint32_t baseInterval) {
+    printf("Background measurements every %u s, %zu recorded sessions\n", baseInterval / 1000, sessions.size());
+    DayUsage fixed = SimulateDay(sessions, baseInterval, false);
+    DayUsage adaptive = SimulateDay(sessions, baseInterval, true);
+    PrintUsage("Fixed", fixed);
+    PrintUsage("Scheduler", adaptive);
+    if (fixed.charge > 0) {
+      printf("LED charge: %+.0f %%\n", (adaptive.charge / fixed.charge - 1) * 100);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  bool csv = false;
+  uint32_t batteryInterval = 0;
+  const char* path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--csv") == 0) {
+      csv = true;
+    } else if (strcmp(argv[i], "--battery") == 0 && i + 1 < argc) {
+      batteryInterval = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)) * 1000;
+    } else {
+      path = argv[i];
+    }
+  }
+  if (path == nullptr) {
+    fprintf(stderr, "Usage: %s [--csv | --battery <interval in s>] <capture file>\n", argv[0]);
+    return 1;
+  }
+
+  auto sessions = ReadCapture(path);
+  if (sessions.empty()) {
+    fprintf(stderr, "No capture session found in %s\n", path);
+    return 1;
+  }
+  std::vector<const Session*> validSessions;
+  for (size_t i = 0; i < sessions.size(); i++) {
+    if (sessions[i].header.version != PpgCaptureFormat::version) {
+      fprintf(stderr, "Session %zu has unsupported version %u\n", i, sessions[i].header.version);
+      continue;
+    }
+    validSessions.push_back(&sessions[i]);
+  }
+  if (batteryInterval > 0) {
+    if (!validSessions.empty()) {
+      CompareBattery(validSessions, batteryInterval);
+    }
+    return 0;
+  }
+
+  if (csv) {
+    printf("session,time_ms,bpm,confidence,motion\n");
+  }
+  for (const Session* session : validSessions) {
+    Replay(session - sessions.data(), *session, csv);
+  }
+  return 0;
+}
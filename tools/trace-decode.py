@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+
+# Decodes the event trace of the watch (see src/utility/Trace.h) into a timeline.
+#
+# The trace is either read from a file, or fetched over BLE from the diagnostics service
+# (doc/DiagnosticsService.md), which needs the bleak package:
+#
+#   trace-decode.py --address AA:BB:CC:DD:EE:FF --save trace.bin
+#   trace-decode.py trace.bin
+
+import argparse
+import asyncio
+import struct
+import sys
+
+TRACE_CHAR_UUID = "00060002-78fc-48fe-8e23-433b3a1942d0"
+COUNTER_FREQUENCY = 32768
+COUNTER_WRAP = 1 << 24
+
+EVENTS = {
+    1: "TaskSwitch",
+    2: "SpiStart",
+    3: "SpiEnd",
+    4: "TwiStart",
+    5: "TwiEnd",
+    6: "DisplayFlushStart",
+    7: "DisplayFlushEnd",
+    8: "BleGapEvent",
+    9: "FsStart",
+    10: "FsEnd",
+    11: "FlashEraseStart",
+    12: "FlashEraseEnd",
+    13: "Mark",
+}
+
+# Events ending the interval opened by another one
+INTERVALS = {3: (2, "SPI"), 5: (4, "TWI"), 7: (6, "Display flush"), 10: (9, "FS"), 12: (11, "Flash erase")}
+
+FS_OPERATIONS = ["FileOpen", "FileClose", "FileRead", "FileWrite", "FileSeek", "FileDelete", "DirOpen",
+                 "DirClose", "DirRead", "DirRewind", "DirCreate", "Rename", "Stat", "GetAttribute", "SetAttributes",
+                 "RemoveAttribute"]
+
+# BLE_GAP_EVENT_* of NimBLE
+GAP_EVENTS = ["CONNECT", "DISCONNECT", "CONN_CANCEL", "CONN_UPDATE", "CONN_UPDATE_REQ", "L2CAP_UPDATE_REQ",
+              "TERM_FAILURE", "DISC", "DISC_COMPLETE", "ADV_COMPLETE", "ENC_CHANGE", "PASSKEY_ACTION",
+              "NOTIFY_RX", "NOTIFY_TX", "SUBSCRIBE", "MTU", "IDENTITY_RESOLVED", "REPEAT_PAIRING",
+              "PHY_UPDATE_COMPLETE", "EXT_DISC", "PERIODIC_SYNC", "PERIODIC_REPORT", "PERIODIC_SYNC_LOST",
+              "SCAN_REQ_RCVD", "PERIODIC_TRANSFER"]
+
+
+def describe(event, argument, tasks):
+    if event == 1:
+        return tasks.get(argument, "#%d" % argument)
+    if event == 2:
+        return "cs=%d size=%d" % (argument >> 24, argument & 0xffffff)
+    if event == 3:
+        return "cs=%d" % (argument >> 24)
+    if event == 4:
+        return "%s dev=0x%02x reg=0x%02x" % ("write" if argument & 0x10000 else "read", (argument >> 8) & 0xff,
+                                             argument & 0xff)
+    if event == 5:
+        return "ok" if argument == 0 else "failed"
+    if event == 6:
+        return "y=%d lines=%d" % (argument >> 16, argument & 0xffff)
+    if event == 8:
+        return GAP_EVENTS[argument] if argument < len(GAP_EVENTS) else str(argument)
+    if event == 9:
+        operation = argument & 0xff
+        name = FS_OPERATIONS[operation] if operation < len(FS_OPERATIONS) else str(operation)
+        return "%s size=%d" % (name, argument >> 8) if argument >> 8 else name
+    if event == 10:
+        return "result=%d" % struct.unpack("<i", struct.pack("<I", argument))[0]
+    if event == 11:
+        return "address=0x%06x" % argument
+    if event == 13:
+        return "0x%08x" % argument
+    return ""
+
+
+def parse(data):
+    header_format = "<BBHIIIB"
+    version, record_size, count, dropped, counter, uptime, nb_tasks = struct.unpack_from(header_format, data)
+    if version != 1 or record_size != 8:
+        sys.exit("Unsupported trace version %d" % version)
+    offset = struct.calcsize(header_format)
+    tasks = {}
+    for _ in range(nb_tasks):
+        number, name = struct.unpack_from("<B4s", data, offset)
+        tasks[number] = name.split(b"\0")[0].decode(errors="replace")
+        offset += 5
+    records = []
+    for _ in range(count):
+        if offset + 8 > len(data):
+            break
+        header, argument = struct.unpack_from("<II", data, offset)
+        offset += 8
+        if header & 0xff:
+            records.append((header >> 8, header & 0xff, argument))
+    return dropped, counter, uptime, tasks, records
+
+
+def timeline(data, min_duration):
+    dropped, counter, uptime, tasks, records = parse(data)
+    if not records:
+        print("Empty trace")
+        return
+
+    # Unwrap the 24 bits counter: consecutive events are less than 512s apart
+    ticks = []
+    base = 0
+    previous = records[0][0]
+    for timestamp, _, _ in records:
+        if timestamp < previous:
+            base += COUNTER_WRAP
+        ticks.append(base + timestamp)
+        previous = timestamp
+    end = base + counter if counter >= previous else base + COUNTER_WRAP + counter
+
+    def to_ms(tick):
+        return uptime - (end - tick) * 1000.0 / COUNTER_FREQUENCY
+
+    print("%d events, %d dropped while frozen, from %.3f s to %.3f s of uptime" %
+          (len(records), dropped, to_ms(ticks[0]) / 1000, uptime / 1000))
+    task = "?"
+    started = {}
+    durations = {}
+    for tick, (_, event, argument) in zip(ticks, records):
+        duration = ""
+        if event in INTERVALS:
+            start_event, name = INTERVALS[event]
+            if start_event in started:
+                elapsed = (tick - started.pop(start_event)) * 1000.0 / COUNTER_FREQUENCY
+                duration = "%8.3f ms" % elapsed
+                durations.setdefault(name, []).append(elapsed)
+                if elapsed < min_duration:
+                    continue
+        elif any(event == start for start, _ in INTERVALS.values()):
+            started[event] = tick
+        if event == 1:
+            task = tasks.get(argument, "#%d" % argument)
+        if min_duration > 0 and not duration:
+            continue
+        print("%12.3f  %-4s %-18s %-28s %s" % (to_ms(tick), task, EVENTS.get(event, str(event)),
+                                               describe(event, argument, tasks), duration))
+
+    print("\n%-14s %6s %10s %10s %10s" % ("Interval", "count", "mean ms", "max ms", "total ms"))
+    for name, values in sorted(durations.items()):
+        print("%-14s %6d %10.3f %10.3f %10.3f" % (name, len(values), sum(values) / len(values), max(values),
+                                                  sum(values)))
+
+
+async def fetch(address):
+    from bleak import BleakClient
+
+    async with BleakClient(address) as client:
+        await client.write_gatt_char(TRACE_CHAR_UUID, b"\x01", response=True)
+        data = bytearray()
+        while True:
+            chunk = await client.read_gatt_char(TRACE_CHAR_UUID)
+            if not chunk:
+                return bytes(data)
+            data += chunk
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the event trace of the watch into a timeline")
+    parser.add_argument("file", nargs="?", help="trace dump")
+    parser.add_argument("--address", help="fetch the trace from the watch with this BLE address")
+    parser.add_argument("--save", help="save the fetched trace to this file")
+    parser.add_argument("--min-duration", type=float, default=0,
+                        help="only show the intervals lasting at least this number of ms")
+    args = parser.parse_args()
+
+    if args.address:
+        data = asyncio.run(fetch(args.address))
+        if args.save:
+            with open(args.save, "wb") as f:
+                f.write(data)
+    elif args.file:
+        with open(args.file, "rb") as f:
+            data = f.read()
+    else:
+        parser.error("a file or an address is needed")
+    timeline(data, args.min_duration)
+
+
+if __name__ == "__main__":
+    main()